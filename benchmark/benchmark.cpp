@@ -0,0 +1,360 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <sax/iostream.hpp>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include( <boost/container/deque.hpp>)
+#    include <boost/container/deque.hpp>
+#    define STATIC_DEQUE_HAS_BOOST 1
+#endif
+
+#include <sax/splitmix.hpp>
+#include <sax/uniform_int_distribution.hpp>
+
+#include <concurrent_queue.hpp>
+#include <mempool.hpp>
+#include <static_deque.hpp>
+
+// Writes one CSV row per container, element size, chunk size and workload to std::cout:
+//
+//     container,element_size,chunk_size,workload,n,ns_per_op
+//
+// Usage: benchmark [n [repeats]], every workload reports the best of repeats runs.
+
+template<std::size_t Size>
+struct element {
+    static_assert ( Size >= sizeof ( std::uint32_t ) and Size % sizeof ( std::uint32_t ) == 0 );
+
+    std::uint32_t key[ Size / sizeof ( std::uint32_t ) ];
+
+    element ( ) noexcept = default;
+    explicit element ( std::uint32_t k_ ) noexcept : key{ k_ } {}
+};
+
+// A growing power of 2 ring buffer, the simplest double ended queue there is.
+template<typename Type>
+class ring_buffer {
+
+    public:
+    using value_type = Type;
+    using size_type  = std::size_t;
+
+    [[nodiscard]] size_type size ( ) const noexcept { return m_size; }
+
+    [[nodiscard]] value_type & operator[] ( size_type i_ ) noexcept { return m_data[ ( m_front + i_ ) & ( m_capacity - 1 ) ]; }
+
+    void push_back ( value_type const & v_ ) {
+        if ( m_size == m_capacity )
+            grow ( );
+        m_data[ ( m_front + m_size++ ) & ( m_capacity - 1 ) ] = v_;
+    }
+    void push_front ( value_type const & v_ ) {
+        if ( m_size == m_capacity )
+            grow ( );
+        m_front           = ( m_front - 1 ) & ( m_capacity - 1 );
+        m_data[ m_front ] = v_;
+        ++m_size;
+    }
+    void pop_back ( ) noexcept { --m_size; }
+    void pop_front ( ) noexcept {
+        m_front = ( m_front + 1 ) & ( m_capacity - 1 );
+        --m_size;
+    }
+
+    template<typename Function>
+    void for_each ( Function f_ ) {
+        for ( size_type i = 0; i < m_size; ++i )
+            f_ ( operator[] ( i ) );
+    }
+
+    private:
+    void grow ( ) {
+        size_type const c = m_capacity ? 2 * m_capacity : 16;
+        std::unique_ptr<value_type[]> d ( new value_type[ c ] );
+        for ( size_type i = 0; i < m_size; ++i )
+            d[ i ] = operator[] ( i );
+        m_data     = std::move ( d );
+        m_capacity = c;
+        m_front    = 0;
+    }
+
+    std::unique_ptr<value_type[]> m_data;
+    size_type m_capacity = 0, m_front = 0, m_size = 0;
+};
+
+// Every container is walked the fastest way it offers: a member for_each, a for_each over its iterators found through ADL
+// (the segmented one of static_deque), or else a plain loop.
+template<typename Container>
+void iterate ( Container & c_, std::uint64_t & sum_ ) {
+    auto add = [ &sum_ ] ( auto & e ) { sum_ += e.key[ 0 ]; };
+    if constexpr ( requires { c_.for_each ( add ); } )
+        c_.for_each ( add );
+    else if constexpr ( requires { for_each ( c_.begin ( ), c_.end ( ), add ); } )
+        for_each ( c_.begin ( ), c_.end ( ), add );
+    else
+        for ( auto & e : c_ )
+            sum_ += e.key[ 0 ];
+}
+
+// The sink keeps the optimizer from dropping the work.
+inline std::uint64_t sink = 0;
+
+template<typename Function>
+[[nodiscard]] double best_ns ( std::size_t repeats_, Function f_ ) {
+    double best = std::numeric_limits<double>::max ( );
+    for ( std::size_t r = 0; r < repeats_; ++r ) {
+        auto const start = std::chrono::steady_clock::now ( );
+        sink += f_ ( );
+        best = std::min ( best, std::chrono::duration<double, std::nano> ( std::chrono::steady_clock::now ( ) - start ).count ( ) );
+    }
+    return best;
+}
+
+template<typename Container>
+void run ( std::string_view name_, std::size_t element_size_, std::size_t chunk_size_, std::size_t n_, std::size_t repeats_ ) {
+
+    using value_type = typename Container::value_type;
+
+    auto report = [ & ] ( std::string_view workload_, std::size_t ops_, double ns_ ) {
+        std::cout << name_ << ',' << element_size_ << ',' << chunk_size_ << ',' << workload_ << ',' << n_ << ','
+                  << ns_ / static_cast<double> ( ops_ ) << nl;
+    };
+
+    report ( "push_pop_back", 2 * n_, best_ns ( repeats_, [ & ] {
+                 Container c;
+                 for ( std::size_t i = 0; i < n_; ++i )
+                     c.push_back ( value_type ( static_cast<std::uint32_t> ( i ) ) );
+                 std::uint64_t s = c.size ( );
+                 for ( std::size_t i = 0; i < n_; ++i )
+                     c.pop_back ( );
+                 return s;
+             } ) );
+
+    report ( "push_pop_front", 2 * n_, best_ns ( repeats_, [ & ] {
+                 Container c;
+                 for ( std::size_t i = 0; i < n_; ++i )
+                     c.push_front ( value_type ( static_cast<std::uint32_t> ( i ) ) );
+                 std::uint64_t s = c.size ( );
+                 for ( std::size_t i = 0; i < n_; ++i )
+                     c.pop_front ( );
+                 return s;
+             } ) );
+
+    // A queue holding 1024 elements, every element passes through it.
+    report ( "fifo_churn", 2 * n_, best_ns ( repeats_, [ & ] {
+                 Container c;
+                 std::uint64_t s = 0;
+                 for ( std::size_t i = 0; i < n_; ++i ) {
+                     c.push_back ( value_type ( static_cast<std::uint32_t> ( i ) ) );
+                     if ( c.size ( ) > 1024u ) {
+                         s += c[ 0 ].key[ 0 ];
+                         c.pop_front ( );
+                     }
+                 }
+                 return s;
+             } ) );
+
+    // Loading a batch in one go, only where there is a bulk append to measure.
+    if constexpr ( requires ( Container & c_, std::vector<value_type> const & v_ ) { c_.append_range ( v_ ); } ) {
+        std::vector<value_type> v;
+        v.reserve ( n_ );
+        for ( std::size_t i = 0; i < n_; ++i )
+            v.emplace_back ( static_cast<std::uint32_t> ( i ) );
+        report ( "append_range", n_, best_ns ( repeats_, [ & ] {
+                     Container c;
+                     c.append_range ( v );
+                     return std::uint64_t{ c.size ( ) };
+                 } ) );
+    }
+
+    Container c;
+    for ( std::size_t i = 0; i < n_; ++i )
+        c.push_back ( value_type ( static_cast<std::uint32_t> ( i ) ) );
+
+    report ( "random_access", n_, best_ns ( repeats_, [ & ] {
+                 sax::splitmix64 rng ( 0x5eed );
+                 sax::uniform_int_distribution<std::size_t> dis ( 0, n_ - 1 );
+                 std::uint64_t s = 0;
+                 for ( std::size_t i = 0; i < n_; ++i )
+                     s += c[ dis ( rng ) ].key[ 0 ];
+                 return s;
+             } ) );
+
+    report ( "iterate", n_, best_ns ( repeats_, [ & ] {
+                 std::uint64_t s = 0;
+                 iterate ( c, s );
+                 return s;
+             } ) );
+
+    // Quadratic, so on a smaller container, and only where there is an insert and erase to measure.
+    if constexpr ( requires { c.erase ( c.insert ( c.begin ( ), value_type ( ) ) ); } ) {
+        std::size_t const m = std::min<std::size_t> ( n_, 1u << 14 );
+        report ( "middle_insert_erase", 2 * m, best_ns ( repeats_, [ & ] {
+                     Container d;
+                     for ( std::size_t i = 0; i < m; ++i )
+                         d.insert ( d.begin ( ) + static_cast<std::ptrdiff_t> ( d.size ( ) / 2 ),
+                                    value_type ( static_cast<std::uint32_t> ( i ) ) );
+                     std::uint64_t s = d.size ( );
+                     for ( std::size_t i = 0; i < m; ++i )
+                         d.erase ( d.begin ( ) + static_cast<std::ptrdiff_t> ( d.size ( ) / 2 ) );
+                     return s;
+                 } ) );
+    }
+}
+
+// The allocators, one object at a time.
+
+template<typename Type>
+struct new_delete {
+    [[nodiscard]] static Type * allocate ( ) { return static_cast<Type *> ( ::operator new ( sizeof ( Type ) ) ); }
+    static void deallocate ( Type * p_ ) noexcept { ::operator delete ( p_, sizeof ( Type ) ); }
+};
+
+// Runs f_ ( t ) on threads_ threads.
+template<typename Function>
+void on_threads ( std::size_t threads_, Function f_ ) {
+    std::vector<std::thread> t;
+    for ( std::size_t i = 0; i < threads_; ++i )
+        t.emplace_back ( f_, i );
+    for ( std::thread & i : t )
+        i.join ( );
+}
+
+template<typename Allocator>
+void run_allocator ( std::string_view name_, std::size_t element_size_, std::size_t chunk_size_, std::size_t n_,
+                     std::size_t repeats_ ) {
+
+    using value_type = std::remove_pointer_t<decltype ( Allocator::allocate ( ) )>;
+    using pointer    = value_type *;
+
+    std::size_t const threads = std::max ( 2u, std::thread::hardware_concurrency ( ) ), producers = threads / 2u,
+                      consumers = threads - producers, per_thread = std::max<std::size_t> ( n_ / threads, 64u ),
+                      per_producer = std::max<std::size_t> ( n_ / producers, 1u );
+
+    auto report = [ & ] ( std::string_view workload_, std::size_t ops_, double ns_ ) {
+        std::cout << name_ << ',' << element_size_ << ',' << chunk_size_ << ',' << workload_ << ',' << n_ << ','
+                  << ns_ / static_cast<double> ( ops_ ) << nl;
+    };
+
+    // Every thread frees what it allocated, in batches of 64.
+    report ( "thread_local_alloc_free", 2 * threads * per_thread, best_ns ( repeats_, [ & ] {
+                 std::atomic<std::uint64_t> s = 0;
+                 on_threads ( threads, [ & ] ( std::size_t ) {
+                     pointer b[ 64 ];
+                     std::uint64_t l = 0;
+                     for ( std::size_t i = 0; i < per_thread; i += 64u ) {
+                         for ( pointer & p : b )
+                             p = ::new ( Allocator::allocate ( ) ) value_type ( static_cast<std::uint32_t> ( i ) );
+                         for ( pointer p : b ) {
+                             l += p->key[ 0 ];
+                             Allocator::deallocate ( p );
+                         }
+                     }
+                     s += l;
+                 } );
+                 return s.load ( );
+             } ) );
+
+    // Half the threads allocate, the other half free, the objects go from one to the other through a queue. This is the
+    // exchange of full and empty magazines between threads in a concurrent_mempool.
+    report ( "producer_consumer", 2 * producers * per_producer, best_ns ( repeats_, [ & ] {
+                 mpmc_queue<pointer> q ( 4'096u );
+                 std::atomic<std::size_t> left = producers * per_producer;
+                 std::atomic<std::uint64_t> s  = 0;
+                 on_threads ( producers + consumers, [ & ] ( std::size_t t_ ) {
+                     std::uint64_t l = 0;
+                     if ( t_ < producers ) {
+                         for ( std::size_t i = 0; i < per_producer; ++i ) {
+                             pointer p = ::new ( Allocator::allocate ( ) ) value_type ( static_cast<std::uint32_t> ( i ) );
+                             while ( not q.try_push ( std::move ( p ) ) )
+                                 std::this_thread::yield ( );
+                         }
+                     }
+                     else {
+                         pointer p;
+                         while ( left.load ( std::memory_order_relaxed ) ) {
+                             if ( not q.try_pop ( p ) ) {
+                                 std::this_thread::yield ( );
+                                 continue;
+                             }
+                             left.fetch_sub ( 1u, std::memory_order_relaxed );
+                             l += p->key[ 0 ];
+                             Allocator::deallocate ( p );
+                         }
+                     }
+                     s += l;
+                 } );
+                 return s.load ( );
+             } ) );
+}
+
+template<std::size_t ElementSize>
+void run_allocators ( std::size_t n_, std::size_t repeats_ ) {
+    using value_type = element<ElementSize>;
+    using pool       = concurrent_mempool<value_type, std::uint32_t>;
+    run_allocator<pool> ( "concurrent_mempool", ElementSize, pool::pool_type::chunck_bytes, n_, repeats_ );
+    run_allocator<new_delete<value_type>> ( "new_delete", ElementSize, 0, n_, repeats_ );
+}
+
+template<std::size_t ElementSize, std::size_t... ChunkSizes>
+void run_element ( std::size_t n_, std::size_t repeats_ ) {
+    using value_type = element<ElementSize>;
+    ( run<static_deque<value_type, std::uint32_t, ChunkSizes>> ( "static_deque", ElementSize, ChunkSizes, n_, repeats_ ), ... );
+    run<std::deque<value_type>> ( "std::deque", ElementSize, 0, n_, repeats_ );
+#if STATIC_DEQUE_HAS_BOOST
+    run<boost::container::deque<value_type>> ( "boost::container::deque", ElementSize, 0, n_, repeats_ );
+#endif
+    run<ring_buffer<value_type>> ( "ring_buffer", ElementSize, 0, n_, repeats_ );
+}
+
+int main ( int argc, char ** argv ) {
+    std::size_t const n       = argc > 1 ? std::stoull ( argv[ 1 ] ) : 1u << 20;
+    std::size_t const repeats = argc > 2 ? std::stoull ( argv[ 2 ] ) : 5u;
+    std::cout << "container,element_size,chunk_size,workload,n,ns_per_op" << nl;
+    run_element<4, 64, 512, 4'096, 65'536> ( n, repeats );
+    run_element<16, 64, 512, 4'096, 65'536> ( n, repeats );
+    run_element<64, 64, 512, 4'096, 65'536> ( n, repeats );
+    run_element<256, 64, 512, 4'096, 65'536> ( n, repeats );
+    run_allocators<16> ( n, repeats );
+    run_allocators<64> ( n, repeats );
+    std::cerr << sink << nl;
+    return EXIT_SUCCESS;
+}
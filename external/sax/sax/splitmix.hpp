@@ -0,0 +1,56 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// The part of sax/splitmix.hpp (https://github.com/degski/sax) this repository uses.
+
+#include <cstdint>
+
+#pragma once
+
+namespace sax {
+
+// Sebastiano Vigna's splitmix64, http://xorshift.di.unimi.it/splitmix64.c.
+class splitmix64 {
+
+    std::uint64_t m_state;
+
+    public:
+    using result_type = std::uint64_t;
+
+    explicit splitmix64 ( result_type s_ = 0xdeadbeefdeadbeefull ) noexcept : m_state ( s_ ) {}
+
+    [[nodiscard]] static constexpr result_type min ( ) noexcept { return 0u; }
+    [[nodiscard]] static constexpr result_type max ( ) noexcept { return ~result_type{ 0u }; }
+
+    void seed ( result_type s_ ) noexcept { m_state = s_; }
+
+    [[nodiscard]] result_type operator( ) ( ) noexcept {
+        result_type z = ( m_state += 0x9e3779b97f4a7c15ull );
+        z             = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+        z             = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+        return z ^ ( z >> 31 );
+    }
+};
+
+} // namespace sax
@@ -0,0 +1,374 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <static_deque.hpp>
+
+#pragma once
+
+// An unbounded, wait-free single producer single consumer queue. The elements are stored in chunks of ChunkSize elements that
+// form a ring, the producer moves on to the next chunk in the ring once the consumer is done with it, or else links a new chunk
+// into the ring in front of it. Chunks are recycled this way and only freed on destruction. The producer and the consumer each
+// publish their progress with a single release store, also in the bulk operations.
+template<typename Type, std::size_t ChunkSize = 512u>
+class spsc_queue {
+
+    static_assert ( is_power_2 ( ChunkSize ), "Template parameter 2 must be an integral value with a value a power of 2" );
+
+    public:
+    using value_type    = Type;
+    using pointer       = value_type *;
+    using const_pointer = value_type const *;
+
+    using reference       = value_type &;
+    using const_reference = value_type const &;
+    using rv_reference    = value_type &&;
+
+    using size_type = std::size_t;
+
+    static constexpr size_type chunck_size = ChunkSize;
+
+    explicit spsc_queue ( ) : m_tail ( new chunk ), m_head ( m_tail ) { m_tail->next.store ( m_tail, std::memory_order_relaxed ); }
+
+    spsc_queue ( spsc_queue const & ) = delete;
+    spsc_queue & operator= ( spsc_queue const & ) = delete;
+
+    ~spsc_queue ( ) noexcept {
+        for ( size_type h = m_head_index, t = m_enqueued.load ( std::memory_order_acquire ); h != t; ++h ) {
+            if ( h == m_head_base + chunck_size ) {
+                m_head      = m_head->next.load ( std::memory_order_relaxed );
+                m_head_base = h;
+            }
+            m_head->slot ( h )->~value_type ( );
+        }
+        chunk * c = m_head->next.load ( std::memory_order_relaxed );
+        while ( c != m_head )
+            delete std::exchange ( c, c->next.load ( std::memory_order_relaxed ) );
+        delete m_head;
+    }
+
+    // Producer.
+
+    template<typename... Args>
+    void emplace ( Args &&... args_ ) {
+        size_type const t = m_tail_index;
+        if ( t == m_tail->base + chunck_size )
+            next_chunk ( t );
+        ::new ( m_tail->slot ( t ) ) value_type ( std::forward<Args> ( args_ )... );
+        m_tail_index = t + 1;
+        m_enqueued.store ( t + 1, std::memory_order_release );
+    }
+
+    void push ( const_reference v_ ) { emplace ( v_ ); }
+    void push ( rv_reference v_ ) { emplace ( std::move ( v_ ) ); }
+
+    // Enqueues [ f_, f_ + n_ ), the elements become visible to the consumer all at once.
+    template<typename InputIt>
+    void push_bulk ( InputIt f_, size_type n_ ) {
+        size_type t = m_tail_index;
+        try {
+            for ( ; n_; --n_, ++f_, ++t ) {
+                if ( t == m_tail->base + chunck_size )
+                    next_chunk ( t );
+                ::new ( m_tail->slot ( t ) ) value_type ( *f_ );
+            }
+        }
+        catch ( ... ) {
+            publish ( t );
+            throw;
+        }
+        publish ( t );
+    }
+
+    // Consumer.
+
+    [[nodiscard]] bool try_pop ( reference v_ ) {
+        size_type const h = m_head_index;
+        if ( h == m_tail_cache and h == ( m_tail_cache = m_enqueued.load ( std::memory_order_acquire ) ) )
+            return false;
+        pointer p = head_slot ( h );
+        v_        = std::move ( *p );
+        p->~value_type ( );
+        m_head_index = h + 1;
+        m_dequeued.store ( h + 1, std::memory_order_release );
+        return true;
+    }
+
+    // Moves up to n_ elements to o_, returns the number of elements dequeued.
+    template<typename OutputIt>
+    [[maybe_unused]] size_type try_pop_bulk ( OutputIt o_, size_type n_ ) {
+        size_type h = m_head_index;
+        if ( m_tail_cache - h < n_ )
+            m_tail_cache = m_enqueued.load ( std::memory_order_acquire );
+        size_type const e = h + std::min ( n_, m_tail_cache - h );
+        for ( ; h != e; ++h, ++o_ ) {
+            pointer p = head_slot ( h );
+            *o_       = std::move ( *p );
+            p->~value_type ( );
+        }
+        n_           = h - m_head_index;
+        m_head_index = h;
+        m_dequeued.store ( h, std::memory_order_release );
+        return n_;
+    }
+
+    // Either side.
+
+    [[nodiscard]] size_type size_approx ( ) const noexcept {
+        return m_enqueued.load ( std::memory_order_relaxed ) - m_dequeued.load ( std::memory_order_relaxed );
+    }
+    [[nodiscard]] bool empty_approx ( ) const noexcept { return not size_approx ( ); }
+
+    private:
+    struct chunk {
+        std::atomic<chunk *> next = nullptr;
+        size_type base            = 0; // The index of the first element, only used by the producer.
+        alignas ( value_type ) unsigned char storage[ chunck_size * sizeof ( value_type ) ];
+
+        [[nodiscard]] pointer slot ( size_type i_ ) noexcept {
+            return std::launder ( reinterpret_cast<pointer> ( storage ) ) + ( i_ & ( chunck_size - 1 ) );
+        }
+    };
+
+    void publish ( size_type t_ ) noexcept {
+        m_tail_index = t_;
+        m_enqueued.store ( t_, std::memory_order_release );
+    }
+
+    // Makes the chunk that receives index t_ (a multiple of chunck_size) the tail.
+    void next_chunk ( size_type t_ ) {
+        // The consumer only leaves a chunk when it takes the first element of the next one, until then it needs the link.
+        chunk * n = m_tail->next.load ( std::memory_order_relaxed );
+        if ( m_head_cache <= n->base + chunck_size )
+            m_head_cache = m_dequeued.load ( std::memory_order_acquire );
+        if ( m_head_cache <= n->base + chunck_size ) {
+            chunk * c = new chunk;
+            c->next.store ( n, std::memory_order_relaxed );
+            m_tail->next.store ( c, std::memory_order_release );
+            n = c;
+        }
+        n->base = t_;
+        m_tail  = n;
+    }
+
+    [[nodiscard]] pointer head_slot ( size_type h_ ) noexcept {
+        if ( h_ == m_head_base + chunck_size ) {
+            m_head      = m_head->next.load ( std::memory_order_acquire );
+            m_head_base = h_;
+        }
+        return m_head->slot ( h_ );
+    }
+
+    // Producer side.
+    alignas ( 64 ) chunk * m_tail;
+    size_type m_tail_index = 0, m_head_cache = 0;
+    alignas ( 64 ) std::atomic<size_type> m_enqueued = 0;
+
+    // Consumer side.
+    alignas ( 64 ) chunk * m_head;
+    size_type m_head_index = 0, m_head_base = 0, m_tail_cache = 0;
+    alignas ( 64 ) std::atomic<size_type> m_dequeued = 0;
+};
+
+// A bounded, lock-free multi producer multi consumer queue (Vyukov), the capacity is rounded up to a power of 2 number of chunks.
+// Every cell carries a sequence number that tells producers and consumers for which lap the cell is free or full. The bulk
+// operations claim a run of consecutive ready cells with a single compare and swap. Elements are moved in and out, which must not
+// throw, as a claimed cell cannot be given back.
+template<typename Type, std::size_t ChunkSize = 512u>
+class mpmc_queue {
+
+    static_assert ( is_power_2 ( ChunkSize ), "Template parameter 2 must be an integral value with a value a power of 2" );
+    static_assert ( std::is_nothrow_move_constructible_v<Type> and std::is_nothrow_move_assignable_v<Type>,
+                    "Template parameter 1 must be nothrow movable" );
+
+    public:
+    using value_type    = Type;
+    using pointer       = value_type *;
+    using const_pointer = value_type const *;
+
+    using reference       = value_type &;
+    using const_reference = value_type const &;
+    using rv_reference    = value_type &&;
+
+    using size_type = std::size_t;
+
+    static constexpr size_type chunck_size = ChunkSize;
+
+    explicit mpmc_queue ( size_type capacity_ ) :
+        m_chuncks ( next_power_2 ( ( std::max ( capacity_, size_type{ 1 } ) - 1 ) / chunck_size ) ),
+        m_mask ( m_chuncks * chunck_size - 1 ), m_map ( new chunk *[ m_chuncks ] ( ) ) {
+        try {
+            for ( size_type c = 0; c < m_chuncks; ++c ) {
+                m_map[ c ] = new chunk;
+                for ( size_type i = 0; i < chunck_size; ++i )
+                    m_map[ c ]->cells[ i ].sequence.store ( c * chunck_size + i, std::memory_order_relaxed );
+            }
+        }
+        catch ( ... ) {
+            release ( );
+            throw;
+        }
+    }
+
+    mpmc_queue ( mpmc_queue const & ) = delete;
+    mpmc_queue & operator= ( mpmc_queue const & ) = delete;
+
+    ~mpmc_queue ( ) noexcept {
+        for ( size_type h = m_dequeue_pos.load ( std::memory_order_relaxed ), t = m_enqueue_pos.load ( std::memory_order_relaxed );
+              h != t; ++h )
+            cell_at ( h ).value ( )->~value_type ( );
+        release ( );
+    }
+
+    [[nodiscard]] size_type capacity ( ) const noexcept { return m_mask + 1; }
+
+    template<typename... Args>
+    [[nodiscard]] bool try_emplace ( Args &&... args_ ) {
+        value_type v ( std::forward<Args> ( args_ )... );
+        return try_push ( std::move ( v ) );
+    }
+
+    [[nodiscard]] bool try_push ( const_reference v_ ) { return try_emplace ( v_ ); }
+    [[nodiscard]] bool try_push ( rv_reference v_ ) noexcept {
+        size_type const p = claim<enqueue> ( m_enqueue_pos, 1 ).first;
+        if ( p == npos )
+            return false;
+        publish_push ( p, std::move ( v_ ) );
+        return true;
+    }
+
+    // Moves as many elements of [ f_, f_ + n_ ) as there are free cells, returns the number of elements enqueued.
+    template<typename InputIt>
+    [[maybe_unused]] size_type try_push_bulk ( InputIt f_, size_type n_ ) noexcept {
+        auto const [ p, k ] = claim<enqueue> ( m_enqueue_pos, n_ );
+        for ( size_type i = 0; i < k; ++i, ++f_ )
+            publish_push ( p + i, std::move ( *f_ ) );
+        return k;
+    }
+
+    [[nodiscard]] bool try_pop ( reference v_ ) noexcept {
+        size_type const p = claim<dequeue> ( m_dequeue_pos, 1 ).first;
+        if ( p == npos )
+            return false;
+        publish_pop ( p, v_ );
+        return true;
+    }
+
+    // Moves up to n_ elements to o_, returns the number of elements dequeued.
+    template<typename OutputIt>
+    [[maybe_unused]] size_type try_pop_bulk ( OutputIt o_, size_type n_ ) noexcept {
+        auto const [ p, k ] = claim<dequeue> ( m_dequeue_pos, n_ );
+        for ( size_type i = 0; i < k; ++i, ++o_ )
+            publish_pop ( p + i, *o_ );
+        return k;
+    }
+
+    [[nodiscard]] size_type size_approx ( ) const noexcept {
+        size_type const t = m_enqueue_pos.load ( std::memory_order_relaxed ), h = m_dequeue_pos.load ( std::memory_order_relaxed );
+        return t > h ? t - h : 0;
+    }
+
+    private:
+    static constexpr size_type npos  = ~size_type{ 0 };
+    static constexpr int chunck_shift = log_power_2 ( ChunkSize );
+
+    struct cell {
+        std::atomic<size_type> sequence;
+        alignas ( value_type ) unsigned char storage[ sizeof ( value_type ) ];
+
+        [[nodiscard]] pointer value ( ) noexcept { return std::launder ( reinterpret_cast<pointer> ( storage ) ); }
+    };
+
+    struct chunk {
+        cell cells[ chunck_size ];
+    };
+
+    // The sequence of a cell is its position when it is free for the producers of that lap, position + 1 when it is full.
+    enum side : size_type { enqueue = 0, dequeue = 1 };
+
+    [[nodiscard]] cell & cell_at ( size_type p_ ) const noexcept {
+        return m_map[ ( p_ & m_mask ) >> chunck_shift ]->cells[ p_ & ( chunck_size - 1 ) ];
+    }
+
+    // Claims up to n_ consecutive ready cells, returns the first position and the number of cells claimed.
+    template<side Side>
+    [[nodiscard]] std::pair<size_type, size_type> claim ( std::atomic<size_type> & pos_, size_type n_ ) noexcept {
+        if ( not n_ )
+            return { npos, 0 };
+        size_type p = pos_.load ( std::memory_order_relaxed );
+        for ( ;; ) {
+            size_type k = 0;
+            while ( k < n_ and cell_at ( p + k ).sequence.load ( std::memory_order_acquire ) == p + k + Side )
+                ++k;
+            if ( k ) {
+                if ( pos_.compare_exchange_weak ( p, p + k, std::memory_order_relaxed ) )
+                    return { p, k };
+            }
+            else {
+                std::make_signed_t<size_type> const d = static_cast<std::make_signed_t<size_type>> (
+                    cell_at ( p ).sequence.load ( std::memory_order_acquire ) - ( p + Side ) );
+                if ( d < 0 )
+                    return { npos, 0 }; // Full (enqueue) or empty (dequeue).
+                p = pos_.load ( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    void publish_push ( size_type p_, rv_reference v_ ) noexcept {
+        cell & c = cell_at ( p_ );
+        ::new ( c.storage ) value_type ( std::move ( v_ ) );
+        c.sequence.store ( p_ + 1, std::memory_order_release );
+    }
+
+    void publish_pop ( size_type p_, reference v_ ) noexcept {
+        cell & c = cell_at ( p_ );
+        pointer e = c.value ( );
+        v_        = std::move ( *e );
+        e->~value_type ( );
+        c.sequence.store ( p_ + m_mask + 1, std::memory_order_release );
+    }
+
+    void release ( ) noexcept {
+        for ( size_type c = 0; c < m_chuncks; ++c )
+            delete m_map[ c ];
+        m_map.reset ( );
+    }
+
+    size_type m_chuncks, m_mask;
+    std::unique_ptr<chunk *[]> m_map;
+
+    alignas ( 64 ) std::atomic<size_type> m_enqueue_pos = 0;
+    alignas ( 64 ) std::atomic<size_type> m_dequeue_pos = 0;
+};
@@ -0,0 +1,577 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <trie.hpp>
+
+#pragma once
+
+// A trie for many readers and few writers. Readers never lock nor write to shared memory other than a reader count of their
+// own (one of stripes, a cache line each). Writers are serialized by a mutex, they never change a node that readers can
+// see but copy the path from the root to the change and publish the new root with a single release store. The nodes that
+// got replaced are retired and freed once no reader that could have seen them is left (epoch based reclamation, with a
+// reader count per epoch parity). Nodes and values come from a trie_arena, which only the writer touches.
+//
+// Values are immutable once inserted, insert_or_assign ( ) replaces the whole value, so that readers always see a complete
+// one. Readers get a copy (find ( )) or a const reference for the duration of a call (visit ( )).
+template<typename Type, typename Allocator = std::allocator<Type>>
+class concurrent_trie {
+
+    static_assert ( alignof ( Type ) <= alignof ( std::max_align_t ), "Template parameter 1 cannot be over aligned" );
+
+    public:
+    using key_type        = std::string_view;
+    using value_type      = Type;
+    using const_reference = value_type const &;
+    using size_type       = std::size_t;
+    using allocator_type  = Allocator;
+
+    static constexpr std::size_t max_prefix = 13u;
+    static constexpr std::size_t stripes    = 64u;
+
+    private:
+    struct leaf {
+        value_type value;
+
+        template<typename... Args>
+        explicit leaf ( Args &&... args_ ) : value ( std::forward<Args> ( args_ )... ) {}
+    };
+
+    // The keys (sorted) and the children follow the node.
+    struct node {
+        leaf * terminal; // The value of the key that ends here.
+        std::uint16_t count;
+        std::uint8_t prefix_len;
+        unsigned char prefix[ max_prefix ];
+
+        [[nodiscard]] static constexpr std::size_t key_bytes ( std::size_t n_ ) noexcept {
+            return ( n_ + 7u ) & ~std::size_t{ 7u };
+        }
+        [[nodiscard]] static constexpr std::size_t size ( std::size_t n_ ) noexcept {
+            return sizeof ( node ) + key_bytes ( n_ ) + n_ * sizeof ( node * );
+        }
+
+        [[nodiscard]] unsigned char * keys ( ) noexcept { return reinterpret_cast<unsigned char *> ( this + 1 ); }
+        [[nodiscard]] unsigned char const * keys ( ) const noexcept { return reinterpret_cast<unsigned char const *> ( this + 1 ); }
+        [[nodiscard]] node ** children ( ) noexcept {
+            return reinterpret_cast<node **> ( reinterpret_cast<char *> ( this + 1 ) + key_bytes ( count ) );
+        }
+        [[nodiscard]] node * const * children ( ) const noexcept {
+            return reinterpret_cast<node * const *> ( reinterpret_cast<char const *> ( this + 1 ) + key_bytes ( count ) );
+        }
+
+        [[nodiscard]] node * child ( unsigned char b_ ) const noexcept {
+            void const * k = std::memchr ( keys ( ), b_, count );
+            return k ? children ( )[ static_cast<unsigned char const *> ( k ) - keys ( ) ] : nullptr;
+        }
+    };
+
+    static_assert ( sizeof ( node ) == 24u );
+
+    static constexpr std::size_t max_block = std::max ( node::size ( 256u ), sizeof ( leaf ) );
+
+    struct alignas ( 64 ) stripe {
+        std::atomic<std::uint32_t> readers[ 2 ] = { 0u, 0u }; // By epoch parity.
+    };
+
+    // Counts the reader in for the current epoch, which is checked again so that a writer that moves the epoch on
+    // concurrently is sure to see the reader in the count of the epoch it was read in.
+    class read_guard {
+
+        public:
+        explicit read_guard ( concurrent_trie const & t_ ) noexcept : m_stripe ( t_.m_stripes[ stripe_index ( ) ] ) {
+            for ( ;; ) {
+                std::uint64_t const e = t_.m_epoch.load ( std::memory_order_seq_cst );
+                m_parity              = e & 1u;
+                m_stripe.readers[ m_parity ].fetch_add ( 1u, std::memory_order_seq_cst );
+                if ( t_.m_epoch.load ( std::memory_order_seq_cst ) == e )
+                    break;
+                m_stripe.readers[ m_parity ].fetch_sub ( 1u, std::memory_order_relaxed );
+            }
+        }
+
+        read_guard ( read_guard const & ) = delete;
+        read_guard & operator= ( read_guard const & ) = delete;
+
+        ~read_guard ( ) noexcept { m_stripe.readers[ m_parity ].fetch_sub ( 1u, std::memory_order_release ); }
+
+        private:
+        stripe & m_stripe;
+        std::size_t m_parity;
+    };
+
+    struct retired {
+        void * block;
+        std::size_t size;
+        bool is_leaf;
+    };
+
+    template<typename T>
+    using rebind = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+    template<typename T>
+    using vector = std::vector<T, rebind<T>>;
+
+    public:
+    explicit concurrent_trie ( allocator_type const & a_ = allocator_type ( ) ) :
+        m_arena ( a_ ), m_path ( a_ ), m_fresh ( a_ ), m_stale ( a_ ), m_limbo{ vector<retired> ( a_ ), vector<retired> ( a_ ),
+                                                                                   vector<retired> ( a_ ) } {}
+
+    concurrent_trie ( concurrent_trie const & ) = delete;
+    concurrent_trie & operator= ( concurrent_trie const & ) = delete;
+
+    ~concurrent_trie ( ) noexcept {
+        destroy_values ( m_root.load ( std::memory_order_relaxed ) );
+        for ( vector<retired> & l : m_limbo )
+            for ( retired const & r : l )
+                if ( r.is_leaf )
+                    static_cast<leaf *> ( r.block )->~leaf ( );
+    }
+
+    // Sizes.
+
+    [[nodiscard]] size_type size ( ) const noexcept { return m_size.load ( std::memory_order_relaxed ); }
+    [[nodiscard]] bool empty ( ) const noexcept { return not size ( ); }
+
+    // Readers, these do not lock.
+
+    // Calls f_ ( value ) with the value of k_, if there is one. The reference is valid during the call only.
+    template<typename Function>
+    bool visit ( key_type k_, Function f_ ) const {
+        read_guard const g ( *this );
+        node const * n = m_root.load ( std::memory_order_acquire );
+        std::size_t i  = 0u;
+        while ( n ) {
+            if ( mismatch ( n, k_, i ) )
+                return false;
+            i += n->prefix_len;
+            if ( i == k_.size ( ) ) {
+                if ( not n->terminal )
+                    return false;
+                f_ ( std::as_const ( n->terminal->value ) );
+                return true;
+            }
+            n = n->child ( static_cast<unsigned char> ( k_[ i++ ] ) );
+        }
+        return false;
+    }
+
+    [[nodiscard]] std::optional<value_type> find ( key_type k_ ) const {
+        std::optional<value_type> v;
+        visit ( k_, [ &v ] ( const_reference v_ ) { v.emplace ( v_ ); } );
+        return v;
+    }
+
+    [[nodiscard]] bool contains ( key_type k_ ) const noexcept {
+        return visit ( k_, [] ( const_reference ) noexcept {} );
+    }
+
+    // Writers, these are serialized.
+
+    // Inserts k_ with a value constructed from args_, unless k_ is there already. Returns whether it was inserted.
+    template<typename... Args>
+    bool try_emplace ( key_type k_, Args &&... args_ ) {
+        return put<false> ( k_, std::forward<Args> ( args_ )... );
+    }
+
+    // Inserts k_ with value v_, or replaces its value. Returns whether it was inserted.
+    template<typename Value>
+    bool insert_or_assign ( key_type k_, Value && v_ ) {
+        return put<true> ( k_, std::forward<Value> ( v_ ) );
+    }
+
+    bool erase ( key_type k_ ) {
+        std::scoped_lock const lock ( m_writer );
+        node * n      = m_root.load ( std::memory_order_relaxed );
+        std::size_t i = 0u;
+        m_path.clear ( );
+        for ( ;; ) {
+            if ( not n or mismatch ( n, k_, i ) )
+                return false;
+            i += n->prefix_len;
+            if ( i == k_.size ( ) )
+                break;
+            unsigned char const b = static_cast<unsigned char> ( k_[ i++ ] );
+            m_path.emplace_back ( n, b );
+            n = n->child ( b );
+        }
+        if ( not n->terminal )
+            return false;
+        commit ( [ & ] {
+            stale ( n->terminal );
+            stale ( n );
+            node * r = nullptr;
+            if ( n->count == 1u )
+                r = merge ( n, n->keys ( )[ 0 ], n->children ( )[ 0 ] );
+            if ( not r and n->count )
+                r = copy ( n, nullptr );
+            for ( auto p = m_path.rbegin ( ); p != m_path.rend ( ); ++p ) {
+                stale ( p->first );
+                r = settle ( p->first, p->second, r );
+            }
+            return r;
+        } );
+        m_size.fetch_sub ( 1u, std::memory_order_relaxed );
+        return true;
+    }
+
+    void clear ( ) {
+        std::scoped_lock const lock ( m_writer );
+        node * root = m_root.load ( std::memory_order_relaxed );
+        if ( not root )
+            return;
+        m_path.clear ( );
+        commit ( [ & ] {
+            m_path.emplace_back ( root, 0u );
+            while ( not m_path.empty ( ) ) {
+                node * n = m_path.back ( ).first;
+                m_path.pop_back ( );
+                if ( n->terminal )
+                    stale ( n->terminal );
+                stale ( n );
+                for ( std::size_t c = 0u; c < n->count; ++c )
+                    m_path.emplace_back ( n->children ( )[ c ], 0u );
+            }
+            return static_cast<node *> ( nullptr );
+        } );
+        m_size.store ( 0u, std::memory_order_relaxed );
+    }
+
+    // Frees what the readers are done with. The writers do this as they go, the retired nodes of a write are freed two writes
+    // later (if the readers allow), this frees them now.
+    void reclaim ( ) {
+        std::scoped_lock const lock ( m_writer );
+        advance ( );
+        advance ( );
+    }
+
+    [[nodiscard]] allocator_type get_allocator ( ) const noexcept { return allocator_type ( m_arena.get_allocator ( ) ); }
+
+    private:
+    [[nodiscard]] static std::size_t stripe_index ( ) noexcept {
+        static std::atomic<std::size_t> next = 0u;
+        thread_local std::size_t const index = next.fetch_add ( 1u, std::memory_order_relaxed ) % stripes;
+        return index;
+    }
+
+    // Whether the prefix of n_ is not what follows the first i_ bytes of k_.
+    [[nodiscard]] static bool mismatch ( node const * n_, key_type k_, std::size_t i_ ) noexcept {
+        return n_->prefix_len > k_.size ( ) - i_ or
+               ( n_->prefix_len and std::memcmp ( n_->prefix, k_.data ( ) + i_, n_->prefix_len ) );
+    }
+
+    template<bool Assign, typename... Args>
+    bool put ( key_type k_, Args &&... args_ ) {
+        std::scoped_lock const lock ( m_writer );
+        node * n      = m_root.load ( std::memory_order_relaxed );
+        std::size_t i = 0u, p = 0u; // Of k_ n has matched i bytes, of n the first p bytes of the prefix match.
+        m_path.clear ( );
+        while ( n ) {
+            std::size_t const m = std::min<std::size_t> ( n->prefix_len, k_.size ( ) - i );
+            p                   = 0u;
+            while ( p < m and n->prefix[ p ] == static_cast<unsigned char> ( k_[ i + p ] ) )
+                ++p;
+            if ( p < n->prefix_len or i + p == k_.size ( ) )
+                break;
+            unsigned char const b = static_cast<unsigned char> ( k_[ i + p ] );
+            node * c              = n->child ( b );
+            if ( not c )
+                break;
+            m_path.emplace_back ( n, b );
+            i += p + 1u;
+            n = c;
+        }
+        bool const exists = n and p == n->prefix_len and i + p == k_.size ( ) and n->terminal;
+        if ( exists and not Assign )
+            return false;
+        commit ( [ & ] {
+            node * r;
+            if ( not n ) {
+                r = chain ( k_.substr ( i ), make_leaf ( std::forward<Args> ( args_ )... ) );
+            }
+            else {
+                if ( p < n->prefix_len ) {
+                    // Split n, the common part goes in front and n follows it under the byte at p.
+                    node * lower = copy ( n, n->terminal );
+                    std::memmove ( lower->prefix, n->prefix + p + 1u, n->prefix_len - p - 1u );
+                    lower->prefix_len      = static_cast<std::uint8_t> ( n->prefix_len - p - 1u );
+                    unsigned char const nb = n->prefix[ p ];
+                    if ( i + p == k_.size ( ) ) {
+                        r                    = make_node ( n->prefix, p, make_leaf ( std::forward<Args> ( args_ )... ), 1u );
+                        r->keys ( )[ 0 ]     = nb;
+                        r->children ( )[ 0 ] = lower;
+                    }
+                    else {
+                        unsigned char const kb = static_cast<unsigned char> ( k_[ i + p ] );
+                        node * t = chain ( k_.substr ( i + p + 1u ), make_leaf ( std::forward<Args> ( args_ )... ) );
+                        r        = make_node ( n->prefix, p, nullptr, 2u );
+                        r->keys ( )[ nb > kb ]     = nb;
+                        r->children ( )[ nb > kb ] = lower;
+                        r->keys ( )[ kb > nb ]     = kb;
+                        r->children ( )[ kb > nb ] = t;
+                    }
+                }
+                else if ( i + p == k_.size ( ) ) {
+                    if ( n->terminal )
+                        stale ( n->terminal );
+                    r = copy ( n, make_leaf ( std::forward<Args> ( args_ )... ) );
+                }
+                else {
+                    node * t = chain ( k_.substr ( i + p + 1u ), make_leaf ( std::forward<Args> ( args_ )... ) );
+                    r        = with_child ( n, static_cast<unsigned char> ( k_[ i + p ] ), t );
+                }
+                stale ( n );
+            }
+            for ( auto q = m_path.rbegin ( ); q != m_path.rend ( ); ++q ) {
+                stale ( q->first );
+                r = with_child ( q->first, q->second, r );
+            }
+            return r;
+        } );
+        if ( exists )
+            return false;
+        m_size.fetch_add ( 1u, std::memory_order_relaxed );
+        return true;
+    }
+
+    // Builds the new tree with f_ ( ), which returns its root, and publishes it. If f_ throws, the new nodes are freed and
+    // the tree is left as it was.
+    template<typename Function>
+    void commit ( Function f_ ) {
+        m_fresh.clear ( );
+        m_stale.clear ( );
+        node * r;
+        try {
+            r                   = f_ ( );
+            vector<retired> & l = m_limbo[ m_epoch.load ( std::memory_order_relaxed ) % 3u ];
+            l.reserve ( l.size ( ) + m_stale.size ( ) );
+        }
+        catch ( ... ) {
+            for ( retired const & f : m_fresh )
+                dispose ( f );
+            m_fresh.clear ( );
+            m_stale.clear ( );
+            throw;
+        }
+        m_root.store ( r, std::memory_order_release );
+        vector<retired> & l = m_limbo[ m_epoch.load ( std::memory_order_relaxed ) % 3u ];
+        l.insert ( l.end ( ), m_stale.begin ( ), m_stale.end ( ) );
+        advance ( );
+    }
+
+    // Moves the epoch on if no reader of the previous one is left, the blocks retired in it are then freed. A reader of the
+    // epoch before that could still be around at the time they were retired, but not after the previous move.
+    void advance ( ) noexcept {
+        std::uint64_t const e = m_epoch.load ( std::memory_order_relaxed );
+        for ( stripe const & s : m_stripes )
+            if ( s.readers[ ( e + 1u ) & 1u ].load ( std::memory_order_seq_cst ) )
+                return;
+        m_epoch.store ( e + 1u, std::memory_order_seq_cst );
+        vector<retired> & l = m_limbo[ ( e + 2u ) % 3u ];
+        for ( retired const & r : l )
+            dispose ( r );
+        l.clear ( );
+    }
+
+    // Allocation, the new blocks are recorded in m_fresh, the replaced ones in m_stale.
+
+    [[nodiscard]] void * allocate ( std::size_t n_, bool is_leaf_ ) {
+        m_fresh.reserve ( m_fresh.size ( ) + 1u );
+        void * p = m_arena.allocate ( n_ );
+        m_fresh.push_back ( { p, n_, is_leaf_ } );
+        return p;
+    }
+
+    template<typename... Args>
+    [[nodiscard]] leaf * make_leaf ( Args &&... args_ ) {
+        m_fresh.reserve ( m_fresh.size ( ) + 1u );
+        void * p = m_arena.allocate ( sizeof ( leaf ) );
+        leaf * l;
+        try {
+            l = ::new ( p ) leaf ( std::forward<Args> ( args_ )... );
+        }
+        catch ( ... ) {
+            m_arena.deallocate ( p, sizeof ( leaf ) );
+            throw;
+        }
+        m_fresh.push_back ( { p, sizeof ( leaf ), true } );
+        return l;
+    }
+
+    [[nodiscard]] node * make_node ( unsigned char const * prefix_, std::size_t length_, leaf * terminal_, std::size_t count_ ) {
+        node * n = static_cast<node *> ( allocate ( node::size ( count_ ), false ) );
+        assert ( length_ <= max_prefix );
+        n->terminal   = terminal_;
+        n->count      = static_cast<std::uint16_t> ( count_ );
+        n->prefix_len = static_cast<std::uint8_t> ( length_ );
+        if ( length_ )
+            std::memcpy ( n->prefix, prefix_, length_ );
+        return n;
+    }
+
+    void stale ( leaf * l_ ) { m_stale.push_back ( { l_, sizeof ( leaf ), true } ); }
+    void stale ( node * n_ ) { m_stale.push_back ( { n_, node::size ( n_->count ), false } ); }
+
+    [[nodiscard]] bool fresh ( node const * n_ ) const noexcept {
+        return std::any_of ( m_fresh.begin ( ), m_fresh.end ( ), [ n_ ] ( retired const & r_ ) { return r_.block == n_; } );
+    }
+
+    void dispose ( retired const & r_ ) noexcept {
+        if ( r_.is_leaf )
+            static_cast<leaf *> ( r_.block )->~leaf ( );
+        m_arena.deallocate ( r_.block, r_.size );
+    }
+
+    // The rest of a key, as a chain of nodes ending in l_.
+    [[nodiscard]] node * chain ( key_type r_, leaf * l_ ) {
+        node * top   = nullptr;
+        node ** link = &top;
+        while ( r_.size ( ) > max_prefix ) {
+            node * n         = make_node ( reinterpret_cast<unsigned char const *> ( r_.data ( ) ), max_prefix, nullptr, 1u );
+            n->keys ( )[ 0 ] = static_cast<unsigned char> ( r_[ max_prefix ] );
+            *link            = n;
+            link             = n->children ( );
+            r_.remove_prefix ( max_prefix + 1u );
+        }
+        *link = make_node ( reinterpret_cast<unsigned char const *> ( r_.data ( ) ), r_.size ( ), l_, 0u );
+        return top;
+    }
+
+    [[nodiscard]] node * copy ( node const * n_, leaf * terminal_ ) {
+        node * c = make_node ( n_->prefix, n_->prefix_len, terminal_, n_->count );
+        std::memcpy ( c->keys ( ), n_->keys ( ), n_->count );
+        std::copy_n ( n_->children ( ), n_->count, c->children ( ) );
+        return c;
+    }
+
+    // A copy of n_ with c_ as its child under b_, which is added, replaced or (if c_ is null) removed.
+    [[nodiscard]] node * with_child ( node const * n_, unsigned char b_, node * c_ ) {
+        bool const has          = n_->child ( b_ );
+        std::size_t const count = n_->count + ( c_ and not has ) - ( not c_ and has );
+        node * r                = make_node ( n_->prefix, n_->prefix_len, n_->terminal, count );
+        unsigned char * keys    = r->keys ( );
+        node ** children        = r->children ( );
+        bool done               = not c_;
+        for ( std::size_t i = 0u; i < n_->count; ++i ) {
+            unsigned char const k = n_->keys ( )[ i ];
+            if ( not done and b_ <= k ) {
+                *keys++     = b_;
+                *children++ = c_;
+                done        = true;
+            }
+            if ( k != b_ ) {
+                *keys++     = k;
+                *children++ = n_->children ( )[ i ];
+            }
+        }
+        if ( not done ) {
+            *keys     = b_;
+            *children = c_;
+        }
+        return r;
+    }
+
+    // As with_child ( ), but a node left without a value or children goes, and one left with just a child merges into it.
+    [[nodiscard]] node * settle ( node const * n_, unsigned char b_, node * c_ ) {
+        std::size_t const count = n_->count - ( not c_ );
+        if ( n_->terminal or count > 1u )
+            return with_child ( n_, b_, c_ );
+        if ( not count )
+            return nullptr;
+        if ( c_ ) {
+            if ( node * m = merge ( n_, b_, c_ ) )
+                return m;
+        }
+        else {
+            std::size_t const o = n_->keys ( )[ 0 ] == b_;
+            if ( node * m = merge ( n_, n_->keys ( )[ o ], n_->children ( )[ o ] ) )
+                return m;
+        }
+        return with_child ( n_, b_, c_ );
+    }
+
+    // n_, which has c_ under b_ as its only child and no value, merged into c_. Returns null if their prefixes do not fit
+    // in one node.
+    [[nodiscard]] node * merge ( node const * n_, unsigned char b_, node * c_ ) {
+        std::size_t const m = n_->prefix_len + 1u + c_->prefix_len;
+        if ( m > max_prefix )
+            return nullptr;
+        unsigned char p[ max_prefix ];
+        std::memcpy ( p, n_->prefix, n_->prefix_len );
+        p[ n_->prefix_len ] = b_;
+        std::memcpy ( p + n_->prefix_len + 1u, c_->prefix, c_->prefix_len );
+        if ( not fresh ( c_ ) ) {
+            stale ( c_ );
+            c_ = copy ( c_, c_->terminal );
+        }
+        std::memcpy ( c_->prefix, p, m );
+        c_->prefix_len = static_cast<std::uint8_t> ( m );
+        return c_;
+    }
+
+    // Destroys the values under n_, linking the nodes still to be done through their terminal field.
+    static void destroy_values ( node * n_ ) noexcept {
+        node * work = nullptr;
+        auto push   = [ &work ] ( node * n ) {
+            if ( n->terminal )
+                n->terminal->~leaf ( );
+            n->terminal = reinterpret_cast<leaf *> ( work );
+            work        = n;
+        };
+        if ( n_ )
+            push ( n_ );
+        while ( work ) {
+            node * n = work;
+            work     = reinterpret_cast<node *> ( n->terminal );
+            for ( std::size_t i = 0u; i < n->count; ++i )
+                push ( n->children ( )[ i ] );
+        }
+    }
+
+    alignas ( 64 ) std::atomic<node *> m_root = nullptr;
+    alignas ( 64 ) std::atomic<std::uint64_t> m_epoch = 0u;
+    mutable stripe m_stripes[ stripes ];
+
+    // The writer's.
+    alignas ( 64 ) std::mutex m_writer;
+    trie_arena<Allocator, max_block> m_arena;
+    vector<std::pair<node *, unsigned char>> m_path;
+    vector<retired> m_fresh, m_stale;
+    vector<retired> m_limbo[ 3 ]; // By epoch modulo 3.
+    std::atomic<size_type> m_size = 0u;
+};
@@ -0,0 +1,736 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <static_deque.hpp>
+
+#pragma once
+
+// Pools of fixed size slots, carved from chunks that are aligned to their size, and std::pmr and thread safe front ends.
+
+template<typename T>
+class unique_ptr {
+
+    // https://lokiastari.com/blog/2014/12/30/c-plus-plus-by-example-smart-pointer/
+    // https://codereview.stackexchange.com/questions/163854/my-implementation-for-stdunique-ptr
+
+    public:
+    using value_type    = T;
+    using pointer       = value_type *;
+    using const_pointer = value_type const *;
+
+    using reference       = value_type &;
+    using const_reference = value_type const &;
+
+    explicit unique_ptr ( ) : m_data ( nullptr ) {}
+    // Explicit constructor
+    explicit unique_ptr ( pointer raw ) : m_data ( raw ) {}
+    ~unique_ptr ( ) {
+        if ( is_unique ( ) )
+            delete m_data;
+    }
+
+    // Constructor/Assignment that binds to nullptr
+    // This makes usage with nullptr cleaner
+    unique_ptr ( std::nullptr_t ) : m_data ( nullptr ) {}
+    unique_ptr & operator= ( std::nullptr_t ) {
+        reset ( );
+        return *this;
+    }
+
+    // Constructor/Assignment that allows move semantics
+    unique_ptr ( unique_ptr && moving ) noexcept : m_data ( nullptr ) { moving.swap ( *this ); }
+    unique_ptr & operator= ( unique_ptr && moving ) noexcept {
+        moving.swap ( *this );
+        return *this;
+    }
+
+    // Constructor/Assignment for use with types derived from T
+    template<typename U>
+    explicit unique_ptr ( unique_ptr<U> && moving ) noexcept : m_data ( nullptr ) {
+        unique_ptr<T> tmp ( moving.release ( ) );
+        tmp.swap ( *this );
+    }
+    template<typename U>
+    unique_ptr & operator= ( unique_ptr<U> && moving ) noexcept {
+        unique_ptr<T> tmp ( moving.release ( ) );
+        tmp.swap ( *this );
+        return *this;
+    }
+
+    // Remove compiler generated copy semantics.
+    unique_ptr ( unique_ptr const & ) = delete;
+    unique_ptr & operator= ( unique_ptr const & ) = delete;
+
+    // Const correct access owned object
+    pointer operator-> ( ) const noexcept { return pointer_view ( m_data ); }
+    reference operator* ( ) const { return *pointer_view ( m_data ); }
+
+    // Access to smart pointer state
+    pointer get ( ) const noexcept { return pointer_view ( m_data ); }
+    pointer get ( ) noexcept { return pointer_view ( m_data ); }
+    explicit operator bool ( ) const { return pointer_view ( m_data ); }
+
+    // Modify object state
+    pointer release ( ) noexcept {
+        pointer result = nullptr;
+        std::swap ( result, m_data );
+        return pointer_view ( result );
+    }
+    void swap ( unique_ptr & src ) noexcept { std::swap ( m_data, src.m_data ); }
+
+    void reset ( ) noexcept {
+        pointer tmp = release ( );
+        delete pointer_view ( tmp );
+    }
+    void reset ( pointer ptr_ = pointer ( ) ) noexcept {
+        pointer result = ptr_;
+        std::swap ( result, m_data );
+        delete pointer_view ( result );
+    }
+    template<typename U>
+    void reset ( unique_ptr<U> && moving_ ) noexcept {
+        unique_ptr<T> result ( moving_ );
+        std::swap ( result, *this );
+        delete pointer_view ( result );
+    }
+
+    void weakify ( ) noexcept {
+        m_data = reinterpret_cast<pointer> ( reinterpret_cast<std::uintptr_t> ( pointer_view ( m_data ) ) | weak_mask );
+    }
+    void uniquify ( ) noexcept { m_data &= ptr_mask; }
+
+    void swap_ownership ( unique_ptr & other_ ) noexcept {
+        auto flip = [] ( unique_ptr & u ) {
+            u.m_data = reinterpret_cast<pointer> ( reinterpret_cast<std::uintptr_t> ( u.m_data ) | weak_mask );
+        };
+        flip ( *this );
+        flip ( other_ );
+    }
+
+    [[nodiscard]] bool is_weak ( ) const noexcept {
+        return static_cast<bool> ( reinterpret_cast<std::uintptr_t> ( m_data ) & weak_mask );
+    }
+    [[nodiscard]] bool is_unique ( ) const noexcept { return not is_weak ( ); }
+
+    [[nodiscard]] static constexpr pointer pointer_view ( pointer p_ ) noexcept {
+        return reinterpret_cast<pointer> ( reinterpret_cast<std::uintptr_t> ( p_ ) & ptr_mask );
+    }
+
+    private:
+    pointer m_data;
+
+    static constexpr std::uintptr_t ptr_mask  = 0x00FF'FFFF'FFFF'FFF0;
+    static constexpr std::uintptr_t weak_mask = 0x0000'0000'0000'0001;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace std {
+template<typename T>
+void swap ( unique_ptr<T> & lhs, unique_ptr<T> & rhs ) {
+    lhs.swap ( rhs );
+}
+} // namespace std
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Stephan T Lavavej (STL!) implementation of make_unique, which has been
+// accepted into the C++14 standard. It includes handling for arrays. Paper
+// here: http://isocpp.org/files/papers/N3656.txt
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+template<class T>
+struct _Unique_if {
+    typedef unique_ptr<T> _Single_object;
+};
+// Specialization for unbound array.
+template<class T>
+struct _Unique_if<T[]> {
+    typedef unique_ptr<T[]> _Unknown_bound;
+};
+// Specialization for array of known size.
+template<class T, size_t N>
+struct _Unique_if<T[ N ]> {
+    typedef void _Known_bound;
+};
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Specialization for normal object type.
+template<class T, class... Args>
+typename detail::_Unique_if<T>::_Single_object make_unique ( Args &&... args ) {
+    return unique_ptr<T> ( new T ( std::forward<Args> ( args )... ) );
+}
+// Specialization for unknown bound.
+template<class T>
+typename detail::_Unique_if<T>::_Unknown_bound make_unique ( size_t size ) {
+    typedef typename std::remove_extent<T>::type U;
+    return unique_ptr<T> ( new U[ size ]( ) );
+}
+// Deleted specialization.
+template<class T, class... Args>
+typename detail::_Unique_if<T>::_Known_bound make_unique ( Args &&... ) = delete;
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<class T>
+unique_ptr<T> make_unique_default_init ( ) {
+    return make_unique<T> ( );
+}
+template<class T>
+unique_ptr<T> make_unique_default_init ( std::size_t size ) {
+    return make_unique<T> ( size );
+}
+template<class T, class... Args>
+typename detail::_Unique_if<T>::_Known_bound make_unique_default_init ( Args &&... ) = delete;
+
+// The links (to the next and the previous chunk) an aligned_stack_storage keeps behind its storage.
+inline constexpr std::size_t aligned_stack_storage_header = 2 * sizeof ( char * );
+
+template<std::size_t N, std::align_val_t Align>
+struct aligned_stack_storage {
+
+    explicit constexpr aligned_stack_storage ( ) noexcept : m_next ( this ) {
+        // An object cannot own itself.
+        m_next.weakify ( );
+        assert ( m_next.is_weak ( ) );
+    };
+    aligned_stack_storage ( aligned_stack_storage const & )     = delete;
+    aligned_stack_storage ( aligned_stack_storage && ) noexcept = delete;
+
+    template<typename U>
+    explicit constexpr aligned_stack_storage ( unique_ptr<U> && p_ ) noexcept : m_next ( std::move ( p_ ) ) {
+        assert ( m_next.is_weak ( ) );
+    };
+
+    ~aligned_stack_storage ( ) noexcept = default;
+
+    aligned_stack_storage & operator= ( aligned_stack_storage const & ) = delete;
+    aligned_stack_storage & operator= ( aligned_stack_storage && ) = delete;
+
+    static constexpr std::size_t capacity ( ) noexcept { return char_size; };
+
+    static constexpr std::size_t char_size = N - aligned_stack_storage_header;
+
+    alignas ( static_cast<std::size_t> ( Align ) ) char m_storage[ char_size ];
+    unique_ptr<aligned_stack_storage> m_next;
+    aligned_stack_storage * m_prev = nullptr;
+};
+
+// The slot a mempool keeps a Type in, while the slot is free it holds the link of the free list.
+template<typename Type>
+inline constexpr std::size_t mempool_slot_align = std::max ( alignof ( Type ), alignof ( void * ) );
+template<typename Type>
+inline constexpr std::size_t mempool_slot_size =
+    ( std::max ( sizeof ( Type ), sizeof ( void * ) ) + mempool_slot_align<Type> - 1 ) & ~( mempool_slot_align<Type> - 1 );
+
+// A mempool chunk of bytes (a power of 2, a chunk is aligned to its size) holds the header and as many slots of SlotSize as
+// fit, the remainder is wasted. Of the powers of 2 from MinBytes up to MaxBytes that hold at least MinSlots slots, the smallest
+// that wastes at most 1 / MaxWaste of the chunk is chosen, or else the one that wastes the smallest fraction, f.e. 72 byte slots
+// waste 64 bytes of a 512 byte chunk, but nothing of a 1024 byte one.
+template<std::size_t SlotSize, std::size_t MinBytes = 512u, std::size_t MaxBytes = 65'536u, std::size_t MinSlots = 8u,
+         std::size_t MaxWaste = 64u>
+struct pool_chunk_layout {
+
+    static_assert ( is_power_2 ( MinBytes ) and is_power_2 ( MaxBytes ) and MinBytes <= MaxBytes,
+                    "Template parameters 2 and 3 must be ordered integral values with a value a power of 2" );
+    static_assert ( aligned_stack_storage_header + SlotSize <= MaxBytes,
+                    "Template parameter 3 must be large enough to hold a slot" );
+
+    private:
+    [[nodiscard]] static constexpr std::size_t waste_of ( std::size_t b_ ) noexcept {
+        return ( b_ - aligned_stack_storage_header ) % SlotSize;
+    }
+
+    [[nodiscard]] static constexpr std::size_t select ( std::size_t min_slots_ ) noexcept {
+        std::size_t best = 0;
+        for ( std::size_t b = MinBytes; b <= MaxBytes; b *= 2 ) {
+            if ( b < aligned_stack_storage_header + min_slots_ * SlotSize )
+                continue;
+            if ( waste_of ( b ) * MaxWaste <= b )
+                return b;
+            if ( not best or waste_of ( b ) * best < waste_of ( best ) * b )
+                best = b;
+        }
+        return best;
+    }
+
+    public:
+    static constexpr std::size_t bytes = select ( MinSlots ) ? select ( MinSlots ) : select ( 1 );
+    static constexpr std::size_t slots = ( bytes - aligned_stack_storage_header ) / SlotSize;
+    static constexpr std::size_t waste = waste_of ( bytes );
+};
+
+template<typename Type, typename SizeType, std::size_t ChunkSize = pool_chunk_layout<mempool_slot_size<Type>>::bytes>
+class mempool {
+
+    static_assert ( is_power_2 ( ChunkSize ), "Template parameter 3 must be an integral value with a value a power of 2" );
+
+    public:
+    using value_type    = Type;
+    using pointer       = value_type *;
+    using const_pointer = value_type const *;
+
+    using reference       = value_type &;
+    using const_reference = value_type const &;
+    using rv_reference    = value_type &&;
+
+    using size_type       = SizeType;
+    using difference_type = std::make_signed<size_type>;
+
+    using iterator               = pointer;
+    using const_iterator         = const_pointer;
+    using reverse_iterator       = pointer;
+    using const_reverse_iterator = const_pointer;
+
+    using void_ptr = void *;
+    using char_ptr = char *;
+
+    // A free slot holds the link of the (intrusive) free list.
+    struct free_slot {
+        free_slot * next;
+    };
+
+    static constexpr std::size_t slot_align = mempool_slot_align<value_type>;
+    static constexpr std::size_t slot_size  = mempool_slot_size<value_type>;
+
+    static_assert ( sizeof ( free_slot ) <= slot_size and alignof ( free_slot ) <= slot_align );
+
+    // Chunks are aligned to their size, so the objects in a chunk can link to each other with a (16 bit) chunk_ptr.
+    using aligned_stack_storage     = ::aligned_stack_storage<ChunkSize, static_cast<std::align_val_t> ( ChunkSize )>;
+    using aligned_stack_storage_ptr = aligned_stack_storage *;
+    using unique_ptr                = ::unique_ptr<aligned_stack_storage>;
+
+    static constexpr size_type chunck_size = static_cast<size_type> ( aligned_stack_storage::capacity ( ) / slot_size );
+
+    static_assert ( chunck_size, "Template parameter 3 must be large enough to hold a Type" );
+
+    // The layout of a chunk, the header, chunck_size slots and a tail too small for another slot (see pool_chunk_layout).
+    static constexpr std::size_t chunck_bytes = ChunkSize;
+    static constexpr std::size_t header_size  = aligned_stack_storage_header;
+    static constexpr std::size_t tail_waste   = aligned_stack_storage::capacity ( ) - chunck_size * slot_size;
+
+    // The chunks form a doubly linked list, the front chunk is owned by m_last_data, every chunk owns its successor and the
+    // tail holds a weak link.
+    unique_ptr m_last_data;
+    aligned_stack_storage_ptr m_tail = nullptr;
+    std::size_t m_chunks             = 0;
+
+    explicit mempool ( ) noexcept = default;
+    mempool ( mempool const & )   = delete;
+    mempool ( mempool && m_ ) noexcept :
+        m_last_data ( std::move ( m_.m_last_data ) ), m_tail ( std::exchange ( m_.m_tail, nullptr ) ),
+        m_chunks ( std::exchange ( m_.m_chunks, 0 ) ), m_free ( std::exchange ( m_.m_free, nullptr ) ),
+        m_front ( std::exchange ( m_.m_front, nullptr ) ), m_back ( std::exchange ( m_.m_back, nullptr ) ) {}
+
+    // Releases the chunks back to front, destroying the chain from the front would recurse once per chunk.
+    ~mempool ( ) noexcept { release ( ); }
+
+    mempool & operator= ( mempool const & ) = delete;
+    [[maybe_unused]] mempool & operator= ( mempool && m_ ) noexcept {
+        m_last_data = std::move ( m_.m_last_data );
+        std::swap ( m_tail, m_.m_tail );
+        std::swap ( m_chunks, m_.m_chunks );
+        std::swap ( m_free, m_.m_free );
+        std::swap ( m_front, m_.m_front );
+        std::swap ( m_back, m_.m_back );
+        return *this;
+    }
+
+    // These throw std::bad_alloc, p_ is only moved from if they do not.
+    [[nodiscard]] static unique_ptr allocate_chunck ( ) { return make_unique<aligned_stack_storage> ( ); }
+    [[nodiscard]] static unique_ptr allocate_chunck ( unique_ptr && p_ ) {
+        return make_unique<aligned_stack_storage> ( std::move ( p_ ) );
+    }
+
+    [[nodiscard]] unique_ptr & back_next ( ) const noexcept { return m_tail->m_next; }
+
+    [[nodiscard]] aligned_stack_storage_ptr back ( ) const noexcept { return m_tail; }
+    [[nodiscard]] std::size_t chunks ( ) const noexcept { return m_chunks; }
+
+    // Appends a chunk, returns the new chunk. Throws std::bad_alloc, in which case nothing changes.
+    [[maybe_unused]] aligned_stack_storage_ptr grow ( ) {
+
+        if ( m_tail ) {
+            auto & leaf  = back_next ( );
+            leaf         = mempool::allocate_chunck ( std::move ( leaf ) );
+            leaf->m_prev = m_tail;
+            m_tail       = leaf.get ( );
+        }
+        else {
+            m_last_data = mempool::allocate_chunck ( );
+            m_tail      = m_last_data.get ( );
+        }
+        ++m_chunks;
+        return m_tail;
+    }
+
+    // Releases the tail chunk, the objects in it must have been deallocated (or be abandoned). Its free slots are unlinked
+    // from the free list, which takes a walk of that list.
+    void pop_back ( ) noexcept {
+        assert ( m_tail );
+        char_ptr const b = m_tail->m_storage, e = b + aligned_stack_storage::capacity ( );
+        if ( m_front and b <= m_front and m_front <= e )
+            m_front = m_back = nullptr;
+        for ( free_slot ** s = &m_free; *s; ) {
+            if ( b <= reinterpret_cast<char_ptr> ( *s ) and reinterpret_cast<char_ptr> ( *s ) < e )
+                *s = ( *s )->next;
+            else
+                s = &( *s )->next;
+        }
+        if ( aligned_stack_storage_ptr p = m_tail->m_prev ) {
+            unique_ptr t ( std::move ( p->m_next ) );
+            p->m_next = std::move ( t->m_next ); // The weak link moves back to the new tail.
+            m_tail    = p;
+        }
+        else {
+            unique_ptr t ( std::move ( m_last_data ) );
+            m_tail = nullptr;
+        }
+        --m_chunks;
+    }
+
+    // Releases tail chunks until at most n_ chunks are left, the objects in those must have been deallocated.
+    void shrink ( std::size_t n_ ) noexcept {
+        while ( m_chunks > n_ )
+            pop_back ( );
+    }
+
+    // Releases all chunks, all objects are deallocated.
+    void release ( ) noexcept {
+        m_free  = nullptr;
+        m_front = m_back = nullptr;
+        shrink ( 0 );
+    }
+
+    // Objects.
+
+    // Returns (uninitialized) storage for one value_type, taken from the free list or else carved from the tail chunk. Throws
+    // std::bad_alloc if a chunk is needed and cannot be allocated.
+    [[nodiscard]] pointer allocate ( ) {
+        if ( free_slot * s = m_free ) {
+            m_free = s->next;
+            return reinterpret_cast<pointer> ( s );
+        }
+        if ( m_front == m_back )
+            refill ( );
+        char_ptr p = m_front;
+        m_front += slot_size;
+        return reinterpret_cast<pointer> ( p );
+    }
+
+    void deallocate ( pointer p_ ) noexcept {
+        free_slot * s = reinterpret_cast<free_slot *> ( p_ );
+        s->next       = m_free;
+        m_free        = s;
+    }
+
+    // Writes n_ pointers to (uninitialized) storage to p_, the free list is drained first, after that the slots are carved in
+    // runs of (up to) a chunk. If a chunk cannot be allocated, the slots written so far go back to the free list and
+    // std::bad_alloc is thrown.
+    void allocate_n ( pointer * p_, size_type n_ ) {
+        pointer * const b = p_;
+        for ( ; n_ and m_free; --n_, m_free = m_free->next )
+            *p_++ = reinterpret_cast<pointer> ( m_free );
+        try {
+            while ( n_ ) {
+                if ( m_front == m_back )
+                    refill ( );
+                size_type const r = std::min ( n_, static_cast<size_type> ( ( m_back - m_front ) / slot_size ) );
+                for ( char_ptr const e = m_front + r * slot_size; m_front != e; m_front += slot_size )
+                    *p_++ = reinterpret_cast<pointer> ( m_front );
+                n_ -= r;
+            }
+        }
+        catch ( ... ) {
+            deallocate_n ( b, static_cast<size_type> ( p_ - b ) );
+            throw;
+        }
+    }
+
+    // Links the n_ slots in p_ and splices them onto the free list.
+    void deallocate_n ( pointer const * p_, size_type n_ ) noexcept {
+        if ( not n_ )
+            return;
+        free_slot * const h = reinterpret_cast<free_slot *> ( p_[ 0 ] );
+        free_slot * t       = h;
+        for ( size_type i = 1; i < n_; ++i )
+            t = t->next = reinterpret_cast<free_slot *> ( p_[ i ] );
+        t->next = m_free;
+        m_free  = h;
+    }
+
+    free_slot * m_free = nullptr;
+    // The not yet carved slots [ m_front, m_back ) of the tail chunk.
+    char_ptr m_front = nullptr, m_back = nullptr;
+
+    private:
+    void refill ( ) {
+        m_front = grow ( )->m_storage;
+        m_back  = m_front + chunck_size * slot_size;
+    }
+};
+
+// An unsynchronized std::pmr::memory_resource. Blocks of up to max_block_size bytes are carved from the chunks of a mempool
+// and recycled through a free list per size class, larger or over-aligned requests are passed on to the upstream resource.
+// The chunks are returned when the resource is destroyed.
+template<std::size_t ChunkSize = 4096u>
+class mempool_resource : public std::pmr::memory_resource {
+
+    public:
+    using pool_type = mempool<std::max_align_t, std::size_t, ChunkSize>;
+
+    static constexpr std::size_t granularity    = alignof ( std::max_align_t );
+    static constexpr std::size_t max_block_size = ( pool_type::aligned_stack_storage::capacity ( ) / 4 ) & ~( granularity - 1 );
+
+    static_assert ( max_block_size, "Template parameter 1 is too small to hold a block" );
+
+    explicit mempool_resource ( std::pmr::memory_resource * upstream_ = std::pmr::get_default_resource ( ) ) noexcept :
+        m_upstream ( upstream_ ) {}
+
+    mempool_resource ( mempool_resource const & ) = delete;
+    mempool_resource & operator= ( mempool_resource const & ) = delete;
+
+    [[nodiscard]] std::pmr::memory_resource * upstream_resource ( ) const noexcept { return m_upstream; }
+
+    private:
+    struct free_block {
+        free_block * next;
+    };
+
+    static constexpr std::size_t size_classes = max_block_size / granularity;
+
+    [[nodiscard]] static constexpr std::size_t size_class ( std::size_t n_ ) noexcept {
+        return n_ ? ( n_ - 1 ) / granularity : 0;
+    }
+
+    void push ( void * p_, std::size_t c_ ) noexcept {
+        free_block * b = static_cast<free_block *> ( p_ );
+        b->next        = m_free[ c_ ];
+        m_free[ c_ ]   = b;
+    }
+
+    [[nodiscard]] void * do_allocate ( std::size_t n_, std::size_t a_ ) override {
+        if ( n_ > max_block_size or a_ > granularity )
+            return m_upstream->allocate ( n_, a_ );
+        std::size_t const c = size_class ( n_ );
+        if ( free_block * b = m_free[ c ] ) {
+            m_free[ c ] = b->next;
+            return b;
+        }
+        std::size_t const s = ( c + 1 ) * granularity;
+        if ( static_cast<std::size_t> ( m_end - m_cur ) < s ) {
+            // The new chunk first, if that throws std::bad_alloc nothing has changed. The tail of the current chunk goes to the
+            // free list it fits.
+            char * const c = m_pool.grow ( )->m_storage;
+            if ( std::size_t const r = static_cast<std::size_t> ( m_end - m_cur ) / granularity )
+                push ( m_cur, r - 1 );
+            m_cur = c;
+            m_end = m_cur + pool_type::aligned_stack_storage::capacity ( );
+        }
+        void * p = m_cur;
+        m_cur += s;
+        return p;
+    }
+
+    void do_deallocate ( void * p_, std::size_t n_, std::size_t a_ ) override {
+        if ( n_ > max_block_size or a_ > granularity )
+            m_upstream->deallocate ( p_, n_, a_ );
+        else
+            push ( p_, size_class ( n_ ) );
+    }
+
+    [[nodiscard]] bool do_is_equal ( std::pmr::memory_resource const & r_ ) const noexcept override { return this == &r_; }
+
+    pool_type m_pool;
+    std::array<free_block *, size_classes> m_free = { };
+    char *m_cur = nullptr, *m_end = nullptr;
+    std::pmr::memory_resource * m_upstream;
+};
+
+// A thread safe front end to a mempool, shared by all users of the same template arguments (like a size class of a general
+// purpose allocator). Every thread caches free slots in two magazines (Bonwick), of which the fast paths take no locks and use
+// no atomics. Full and empty magazines are exchanged through a lock-free central depot, which is how slots freed by one thread
+// get back to the threads that allocate. Only fresh slots are carved from the (mutex protected) mempool, a magazine at a time.
+template<typename Type, typename SizeType, std::size_t ChunkSize = pool_chunk_layout<mempool_slot_size<Type>, page_size>::bytes,
+         std::size_t MagazineSize = 64u>
+class concurrent_mempool {
+
+    public:
+    using pool_type = mempool<Type, SizeType, ChunkSize>;
+
+    using value_type = Type;
+    using pointer    = value_type *;
+    using size_type  = SizeType;
+
+    static constexpr std::size_t magazine_size = MagazineSize;
+
+    concurrent_mempool ( ) = delete;
+
+    [[nodiscard]] static pointer allocate ( ) { return s_cache.allocate ( ); }
+    static void deallocate ( pointer p_ ) { s_cache.deallocate ( p_ ); }
+
+    // Returns the magazines of the calling thread to the depot.
+    static void flush ( ) noexcept { s_cache.flush ( ); }
+
+    private:
+    struct magazine {
+        std::atomic<magazine *> next = nullptr;
+        std::size_t count            = 0;
+        pointer slots[ magazine_size ];
+    };
+
+    // A Treiber stack, the ABA problem is dealt with by a 16-bit tag in the upper bits of the (48-bit) head pointer. The
+    // magazines are never freed while in use, so reading the next link of a stale head is safe.
+    class magazine_stack {
+
+        static_assert ( sizeof ( void * ) == 8, "concurrent_mempool requires a 64-bit platform" );
+
+        static constexpr std::uint64_t ptr_mask = 0x0000'FFFF'FFFF'FFFF;
+        static constexpr std::uint64_t tag_unit = 0x0001'0000'0000'0000;
+
+        [[nodiscard]] static magazine * ptr ( std::uint64_t h_ ) noexcept { return reinterpret_cast<magazine *> ( h_ & ptr_mask ); }
+        [[nodiscard]] static std::uint64_t pack ( magazine * m_, std::uint64_t h_ ) noexcept {
+            return ( ( h_ & ~ptr_mask ) + tag_unit ) | reinterpret_cast<std::uint64_t> ( m_ );
+        }
+
+        public:
+        ~magazine_stack ( ) noexcept {
+            while ( magazine * m = pop ( ) )
+                delete m;
+        }
+
+        void push ( magazine * m_ ) noexcept {
+            std::uint64_t h = m_head.load ( std::memory_order_relaxed );
+            do
+                m_->next.store ( ptr ( h ), std::memory_order_relaxed );
+            while ( not m_head.compare_exchange_weak ( h, pack ( m_, h ), std::memory_order_release, std::memory_order_relaxed ) );
+        }
+
+        [[nodiscard]] magazine * pop ( ) noexcept {
+            std::uint64_t h = m_head.load ( std::memory_order_acquire );
+            while ( magazine * m = ptr ( h ) )
+                if ( m_head.compare_exchange_weak ( h, pack ( m->next.load ( std::memory_order_relaxed ), h ),
+                                                    std::memory_order_acquire, std::memory_order_acquire ) )
+                    return m;
+            return nullptr;
+        }
+
+        private:
+        alignas ( 64 ) std::atomic<std::uint64_t> m_head = 0;
+    };
+
+    struct depot {
+        magazine_stack m_full, m_empty;
+        std::mutex m_pool_mutex;
+        pool_type m_pool;
+
+        [[nodiscard]] magazine * empty_magazine ( ) {
+            if ( magazine * m = m_empty.pop ( ) )
+                return m;
+            return new magazine;
+        }
+
+        void fill ( magazine * m_ ) {
+            std::scoped_lock lock ( m_pool_mutex );
+            m_pool.allocate_n ( m_->slots + m_->count, static_cast<size_type> ( magazine_size - m_->count ) );
+            m_->count = magazine_size;
+        }
+    };
+
+    struct thread_cache {
+
+        magazine *m_loaded = nullptr, *m_previous = nullptr;
+
+        ~thread_cache ( ) noexcept { flush ( ); }
+
+        [[nodiscard]] pointer allocate ( ) {
+            if ( not m_loaded )
+                init ( );
+            if ( not m_loaded->count ) {
+                if ( m_previous->count ) {
+                    std::swap ( m_loaded, m_previous );
+                }
+                else if ( magazine * m = s_depot.m_full.pop ( ) ) {
+                    s_depot.m_empty.push ( m_previous );
+                    m_previous = m_loaded;
+                    m_loaded   = m;
+                }
+                else {
+                    s_depot.fill ( m_loaded );
+                }
+            }
+            return m_loaded->slots[ --m_loaded->count ];
+        }
+
+        void deallocate ( pointer p_ ) {
+            if ( not m_loaded )
+                init ( );
+            if ( m_loaded->count == magazine_size ) {
+                if ( m_previous->count < magazine_size ) {
+                    std::swap ( m_loaded, m_previous );
+                }
+                else {
+                    magazine * m = s_depot.empty_magazine ( );
+                    s_depot.m_full.push ( m_previous );
+                    m_previous = m_loaded;
+                    m_loaded   = m;
+                }
+            }
+            m_loaded->slots[ m_loaded->count++ ] = p_;
+        }
+
+        // Partially filled magazines go to the depot as full ones, the depot does not care about the count.
+        void flush ( ) noexcept {
+            for ( magazine * m : { m_loaded, m_previous } )
+                if ( m )
+                    ( m->count ? s_depot.m_full : s_depot.m_empty ).push ( m );
+            m_loaded = m_previous = nullptr;
+        }
+
+        private:
+        void init ( ) {
+            m_loaded   = s_depot.empty_magazine ( );
+            m_previous = s_depot.empty_magazine ( );
+        }
+    };
+
+    static inline depot s_depot;
+    static inline thread_local thread_cache s_cache;
+};
@@ -0,0 +1,209 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <compare>
+#include <limits>
+#include <type_traits>
+
+#include <static_deque.hpp>
+
+#pragma once
+
+// A self relative pointer, it holds the distance in bytes from itself to the pointee. A structure linked with offset_ptr's can
+// be copied (as bytes) or mapped to another address as a whole, copying one offset_ptr recomputes the offset so that it keeps
+// pointing at the same object. The pointee must lie within reach of OffsetType, i.e. +/- 32KB for a 16 bit offset_ptr. An
+// offset of 1 would point into the offset_ptr itself, it is the null pointer.
+template<typename Type, typename OffsetType = std::int32_t>
+class offset_ptr {
+
+    static_assert ( std::is_integral_v<OffsetType> and std::is_signed_v<OffsetType>,
+                    "Template parameter 2 must be a signed integral type" );
+    static_assert ( sizeof ( OffsetType ) > 1, "Template parameter 2 must be wider than a byte" );
+
+    template<typename, typename>
+    friend class offset_ptr;
+
+    public:
+    using element_type    = Type;
+    using value_type      = std::remove_cv_t<Type>;
+    using pointer         = Type *;
+    using reference       = std::add_lvalue_reference_t<Type>;
+    using difference_type = std::ptrdiff_t;
+    using offset_type     = OffsetType;
+
+    offset_ptr ( ) noexcept = default;
+    offset_ptr ( std::nullptr_t ) noexcept {}
+    offset_ptr ( pointer p_ ) noexcept { set ( p_ ); }
+    offset_ptr ( offset_ptr const & o_ ) noexcept { set ( o_.get ( ) ); }
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U *, pointer>>>
+    offset_ptr ( offset_ptr<U, OffsetType> const & o_ ) noexcept {
+        set ( o_.get ( ) );
+    }
+
+    [[maybe_unused]] offset_ptr & operator= ( offset_ptr const & o_ ) noexcept {
+        set ( o_.get ( ) );
+        return *this;
+    }
+    [[maybe_unused]] offset_ptr & operator= ( pointer p_ ) noexcept {
+        set ( p_ );
+        return *this;
+    }
+    [[maybe_unused]] offset_ptr & operator= ( std::nullptr_t ) noexcept {
+        m_offset = null_offset;
+        return *this;
+    }
+
+    // Get.
+
+    [[nodiscard]] pointer get ( ) const noexcept {
+        if ( m_offset == null_offset )
+            return nullptr;
+        return reinterpret_cast<pointer> ( reinterpret_cast<std::uintptr_t> ( this ) + static_cast<std::uintptr_t> ( m_offset ) );
+    }
+
+    [[nodiscard]] pointer operator-> ( ) const noexcept { return get ( ); }
+    [[nodiscard]] reference operator* ( ) const noexcept { return *get ( ); }
+
+    [[nodiscard]] explicit operator bool ( ) const noexcept { return m_offset != null_offset; }
+
+    // The raw offset, null_offset for the null pointer.
+    [[nodiscard]] offset_type offset ( ) const noexcept { return m_offset; }
+
+    // Whether p_ can be stored in this offset_ptr (at its current address).
+    [[nodiscard]] bool reaches ( pointer p_ ) const noexcept {
+        if ( not p_ )
+            return true;
+        std::intptr_t const d = distance ( p_ );
+        return d >= std::numeric_limits<offset_type>::min ( ) and d <= std::numeric_limits<offset_type>::max ( ) and
+               d != null_offset;
+    }
+
+    void swap ( offset_ptr & o_ ) noexcept {
+        pointer const p = get ( );
+        set ( o_.get ( ) );
+        o_.set ( p );
+    }
+
+    [[nodiscard]] friend bool operator== ( offset_ptr const & l_, offset_ptr const & r_ ) noexcept {
+        return l_.get ( ) == r_.get ( );
+    }
+    [[nodiscard]] friend bool operator== ( offset_ptr const & l_, std::nullptr_t ) noexcept { return not l_; }
+    [[nodiscard]] friend std::strong_ordering operator<=> ( offset_ptr const & l_, offset_ptr const & r_ ) noexcept {
+        return std::compare_three_way ( ) ( l_.get ( ), r_.get ( ) );
+    }
+
+    static constexpr offset_type null_offset = 1;
+
+    private:
+    [[nodiscard]] std::intptr_t distance ( pointer p_ ) const noexcept {
+        return static_cast<std::intptr_t> ( reinterpret_cast<std::uintptr_t> ( p_ ) - reinterpret_cast<std::uintptr_t> ( this ) );
+    }
+
+    void set ( pointer p_ ) noexcept {
+        assert ( reaches ( p_ ) );
+        m_offset = p_ ? static_cast<offset_type> ( distance ( p_ ) ) : null_offset;
+    }
+
+    offset_type m_offset = null_offset;
+};
+
+// A chunk relative pointer, it links objects within one chunk of ChunkSize bytes, the chunk being aligned to its size. The base
+// is found by masking the address of the chunk_ptr itself, the offset counts alignof ( Type ) units from there, so a 16 bit
+// chunk_ptr spans chunks of up to 64K of those units. The highest offset is the null pointer.
+template<typename Type, std::size_t ChunkSize, typename OffsetType = std::uint16_t>
+class chunk_ptr {
+
+    static_assert ( is_power_2 ( ChunkSize ), "Template parameter 2 must be an integral value with a value a power of 2" );
+    static_assert ( std::is_integral_v<OffsetType> and std::is_unsigned_v<OffsetType>,
+                    "Template parameter 3 must be an unsigned integral type" );
+
+    public:
+    using element_type    = Type;
+    using value_type      = std::remove_cv_t<Type>;
+    using pointer         = Type *;
+    using reference       = std::add_lvalue_reference_t<Type>;
+    using difference_type = std::ptrdiff_t;
+    using offset_type     = OffsetType;
+
+    static constexpr std::size_t chunck_size = ChunkSize;
+
+    // Copying the value is fine, as long as the copy lives in the same chunk.
+    chunk_ptr ( ) noexcept = default;
+    chunk_ptr ( std::nullptr_t ) noexcept {}
+    chunk_ptr ( pointer p_ ) noexcept { set ( p_ ); }
+
+    [[maybe_unused]] chunk_ptr & operator= ( pointer p_ ) noexcept {
+        set ( p_ );
+        return *this;
+    }
+    [[maybe_unused]] chunk_ptr & operator= ( std::nullptr_t ) noexcept {
+        m_offset = null_offset;
+        return *this;
+    }
+
+    // Get.
+
+    [[nodiscard]] pointer get ( ) const noexcept {
+        return m_offset == null_offset ? nullptr : reinterpret_cast<pointer> ( base ( ) + m_offset * alignof ( Type ) );
+    }
+
+    [[nodiscard]] pointer operator-> ( ) const noexcept { return get ( ); }
+    [[nodiscard]] reference operator* ( ) const noexcept { return *get ( ); }
+
+    [[nodiscard]] explicit operator bool ( ) const noexcept { return m_offset != null_offset; }
+
+    [[nodiscard]] offset_type offset ( ) const noexcept { return m_offset; }
+
+    // Whether p_ lies in the same chunk as this chunk_ptr.
+    [[nodiscard]] bool reaches ( pointer p_ ) const noexcept {
+        return not p_ or ( reinterpret_cast<std::uintptr_t> ( p_ ) & ~( chunck_size - 1 ) ) == base ( );
+    }
+
+    [[nodiscard]] friend bool operator== ( chunk_ptr const & l_, chunk_ptr const & r_ ) noexcept {
+        return l_.get ( ) == r_.get ( );
+    }
+    [[nodiscard]] friend bool operator== ( chunk_ptr const & l_, std::nullptr_t ) noexcept { return not l_; }
+
+    static constexpr offset_type null_offset = std::numeric_limits<offset_type>::max ( );
+
+    private:
+    [[nodiscard]] std::uintptr_t base ( ) const noexcept {
+        return reinterpret_cast<std::uintptr_t> ( this ) & ~static_cast<std::uintptr_t> ( chunck_size - 1 );
+    }
+
+    void set ( pointer p_ ) noexcept {
+        // Here, rather than at class scope, as Type is incomplete in a node that links to its own kind.
+        static_assert ( ChunkSize / alignof ( Type ) <= std::numeric_limits<OffsetType>::max ( ),
+                        "Template parameter 3 is too narrow to index a chunk of template parameter 2 bytes" );
+        assert ( reaches ( p_ ) );
+        m_offset = p_ ? static_cast<offset_type> ( ( reinterpret_cast<std::uintptr_t> ( p_ ) - base ( ) ) / alignof ( Type ) )
+                      : null_offset;
+    }
+
+    offset_type m_offset = null_offset;
+};
@@ -0,0 +1,224 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#if defined( _WIN32 )
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#include <static_deque.hpp>
+
+#pragma once
+
+// Position independent arena images. When the objects in an arena link to each other with offset_ptr's (or chunk_ptr's), the
+// used part of the arena holds no absolute addresses, it can be written to a file as is and mapped back, at whatever address,
+// without fix ups. The objects must be trivially copyable and must not hold raw pointers, the latter is not checked.
+//
+// The file is a pool_image_header, padded to the alignment of the arena, followed by the used bytes of the arena.
+
+struct pool_image_header {
+    static constexpr std::uint64_t magic_value   = 0x6567'616d'6971'6473; // "sdqimage", little endian.
+    static constexpr std::uint32_t version_value = 1u;
+
+    std::uint64_t magic   = magic_value;
+    std::uint32_t version = version_value;
+    std::uint32_t align   = 0u; // The data starts at this offset.
+    std::uint64_t size    = 0u; // Of the data.
+    std::uint64_t root    = 0u; // The offset of the root object in the data.
+};
+
+// The maximum alignment of an image, mappings start at a page boundary.
+inline constexpr std::size_t pool_image_max_align = 4'096u;
+
+// Writes the used part of a_ to path_, root_ (in a_) is the object pool_image::root returns.
+template<std::size_t Size, std::size_t Align, overflow_policy Policy>
+void save_image ( aligned_stack_storage_<Size, Align, Policy> const & a_, void const * root_, char const * path_ ) {
+    static_assert ( Policy != overflow_policy::upstream, "Objects allocated upstream would not be part of the image" );
+    static_assert ( Align <= pool_image_max_align, "The alignment of an image cannot exceed the page size" );
+    char const * const root = static_cast<char const *> ( root_ );
+    if ( not a_.pointer_in_buffer ( root ) or root >= a_.data ( ) + a_.used ( ) )
+        throw std::invalid_argument ( "save_image: the root object is not in the arena" );
+    pool_image_header h;
+    h.align = static_cast<std::uint32_t> ( std::max ( Align, sizeof ( pool_image_header ) ) );
+    h.size  = a_.used ( );
+    h.root  = static_cast<std::uint64_t> ( root - a_.data ( ) );
+    std::unique_ptr<std::FILE, int ( * ) ( std::FILE * )> f ( std::fopen ( path_, "wb" ), &std::fclose );
+    if ( not f )
+        throw std::system_error ( errno, std::generic_category ( ), std::string ( "save_image: " ) + path_ );
+    char const padding[ pool_image_max_align ] = { };
+    if ( std::fwrite ( &h, sizeof ( h ), 1, f.get ( ) ) != 1 or
+         std::fwrite ( padding, 1, h.align - sizeof ( h ), f.get ( ) ) != h.align - sizeof ( h ) or
+         std::fwrite ( a_.data ( ), 1, a_.used ( ), f.get ( ) ) != a_.used ( ) or std::fflush ( f.get ( ) ) )
+        throw std::system_error ( errno, std::generic_category ( ), std::string ( "save_image: " ) + path_ );
+}
+
+// A mapped image, read only or copy on write (the changes stay private to the process).
+class pool_image {
+
+    public:
+    enum class mode { read_only, copy_on_write };
+
+    explicit pool_image ( char const * path_, mode m_ = mode::read_only ) {
+        map ( path_, m_ );
+        pool_image_header h;
+        if ( m_size >= sizeof ( h ) )
+            std::memcpy ( &h, m_base, sizeof ( h ) );
+        if ( m_size < sizeof ( h ) or h.magic != pool_image_header::magic_value or h.version != pool_image_header::version_value or
+             h.align < sizeof ( h ) or h.align > pool_image_max_align or not is_power_2 ( std::size_t{ h.align } ) or
+             h.size != m_size - h.align or ( h.size and h.root >= h.size ) ) {
+            unmap ( );
+            invalid ( path_ );
+        }
+        m_data      = static_cast<char *> ( m_base ) + h.align;
+        m_data_size = static_cast<std::size_t> ( h.size );
+        m_root      = static_cast<std::size_t> ( h.root );
+    }
+
+    pool_image ( pool_image && o_ ) noexcept :
+        m_base ( std::exchange ( o_.m_base, nullptr ) ), m_size ( std::exchange ( o_.m_size, 0u ) ),
+        m_data ( std::exchange ( o_.m_data, nullptr ) ), m_data_size ( std::exchange ( o_.m_data_size, 0u ) ),
+        m_root ( std::exchange ( o_.m_root, 0u ) ) {}
+
+    [[maybe_unused]] pool_image & operator= ( pool_image && o_ ) noexcept {
+        std::swap ( m_base, o_.m_base );
+        std::swap ( m_size, o_.m_size );
+        std::swap ( m_data, o_.m_data );
+        std::swap ( m_data_size, o_.m_data_size );
+        std::swap ( m_root, o_.m_root );
+        return *this;
+    }
+
+    ~pool_image ( ) noexcept { unmap ( ); }
+
+    // The root object, the objects of a read only image must not be written to.
+    template<typename Type>
+    [[nodiscard]] Type * root ( ) const noexcept {
+        return m_data_size ? std::launder ( reinterpret_cast<Type *> ( m_data + m_root ) ) : nullptr;
+    }
+
+    [[nodiscard]] char * data ( ) const noexcept { return m_data; }
+    [[nodiscard]] std::size_t size ( ) const noexcept { return m_data_size; }
+
+    private:
+    [[noreturn]] static void invalid ( char const * path_ ) {
+        throw std::runtime_error ( std::string ( "pool_image: not a valid image " ) + path_ );
+    }
+
+#if defined( _WIN32 )
+    // The error code is taken before a handle is closed, as closing it may overwrite it.
+    void map ( char const * path_, mode m_ ) {
+        auto fail = [ path_ ] ( DWORD error_ ) {
+            throw std::system_error ( static_cast<int> ( error_ ), std::system_category ( ),
+                                      std::string ( "pool_image: " ) + path_ );
+        };
+        HANDLE f = CreateFileA ( path_, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+        if ( f == INVALID_HANDLE_VALUE )
+            fail ( GetLastError ( ) );
+        LARGE_INTEGER s;
+        if ( not GetFileSizeEx ( f, &s ) ) {
+            DWORD const e = GetLastError ( );
+            CloseHandle ( f );
+            fail ( e );
+        }
+        if ( not s.QuadPart ) {
+            CloseHandle ( f );
+            invalid ( path_ );
+        }
+        HANDLE v      = CreateFileMappingA ( f, nullptr, m_ == mode::read_only ? PAGE_READONLY : PAGE_WRITECOPY, 0, 0, nullptr );
+        DWORD const e = GetLastError ( );
+        CloseHandle ( f );
+        if ( not v )
+            fail ( e );
+        m_base         = MapViewOfFile ( v, m_ == mode::read_only ? FILE_MAP_READ : FILE_MAP_COPY, 0, 0, 0 );
+        DWORD const ve = GetLastError ( );
+        CloseHandle ( v ); // The view keeps the mapping alive.
+        if ( not m_base )
+            fail ( ve );
+        m_size = static_cast<std::size_t> ( s.QuadPart );
+    }
+    void unmap ( ) noexcept {
+        if ( m_base )
+            UnmapViewOfFile ( m_base );
+    }
+#else
+    // errno is taken before the file is closed, as closing it may overwrite it.
+    void map ( char const * path_, mode m_ ) {
+        auto fail = [ path_ ] ( int error_ ) {
+            throw std::system_error ( error_, std::generic_category ( ), std::string ( "pool_image: " ) + path_ );
+        };
+        int const f = ::open ( path_, O_RDONLY );
+        if ( f < 0 )
+            fail ( errno );
+        struct stat s;
+        if ( ::fstat ( f, &s ) ) {
+            int const e = errno;
+            ::close ( f );
+            fail ( e );
+        }
+        if ( not s.st_size ) {
+            ::close ( f );
+            invalid ( path_ );
+        }
+        int const prot = m_ == mode::read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+        void * p       = ::mmap ( nullptr, static_cast<std::size_t> ( s.st_size ), prot, MAP_PRIVATE, f, 0 );
+        int const e    = errno;
+        ::close ( f ); // The mapping keeps the file alive.
+        if ( p == MAP_FAILED )
+            fail ( e );
+        m_base = p;
+        m_size = static_cast<std::size_t> ( s.st_size );
+    }
+    void unmap ( ) noexcept {
+        if ( m_base )
+            ::munmap ( m_base, m_size );
+    }
+#endif
+
+    void * m_base           = nullptr;
+    std::size_t m_size      = 0u;
+    char * m_data           = nullptr;
+    std::size_t m_data_size = 0u;
+    std::size_t m_root      = 0u;
+};
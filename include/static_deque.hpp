@@ -25,15 +25,24 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 
+#include <algorithm>
 #include <array>
+#include <initializer_list>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <numeric>
 #include <sax/iostream.hpp>
 #include <random>
+#include <ranges>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
-
-#include <experimental/fixed_capacity_vector>
+#include <utility>
 
 #pragma once
 
@@ -58,23 +67,134 @@ constexpr bool is_power_2 ( T const n_ ) noexcept {
     return n_ and not( n_ & ( n_ - 1 ) );
 }
 
-template<std::size_t Size, std::size_t Align = alignof ( std::max_align_t )>
+template<typename T, typename = std::enable_if_t<std::conjunction_v<std::is_integral<T>, std::is_unsigned<T>>>>
+constexpr int log_power_2 ( T n_ ) noexcept {
+    int l = 0;
+    while ( n_ >>= 1 )
+        ++l;
+    return l;
+}
+
+// The memory granules chunk layouts are tuned to.
+inline constexpr std::size_t cache_line_size = 64u;
+inline constexpr std::size_t page_size       = 4'096u;
+inline constexpr std::size_t huge_page_size  = 2'097'152u;
+
+// A chunk of (a power of 2) elements of ElementSize bytes, of at least MinSize elements and at most MaxBytes, that fills whole
+// Granules (cache lines or pages, f.e.). A chunk of lcm ( ElementSize, Granule ) bytes leaves no tail, i.e. 512 elements of
+// 24 bytes fill 3 pages exactly. If that chunk is too large, the one that wastes the smallest fraction of its last granule is
+// chosen.
+template<std::size_t ElementSize, std::size_t Granule = page_size, std::size_t MinSize = 16u, std::size_t MaxBytes = 64u * Granule>
+struct chunk_layout {
+
+    static_assert ( ElementSize, "Template parameter 1 must not be 0" );
+    static_assert ( is_power_2 ( Granule ), "Template parameter 2 must be an integral value with a value a power of 2" );
+    static_assert ( is_power_2 ( MinSize ), "Template parameter 3 must be an integral value with a value a power of 2" );
+
+    private:
+    [[nodiscard]] static constexpr std::size_t waste_of ( std::size_t n_ ) noexcept {
+        return ( Granule - n_ * ElementSize % Granule ) % Granule;
+    }
+
+    [[nodiscard]] static constexpr std::size_t select ( ) noexcept {
+        std::size_t const exact = std::max ( Granule / std::gcd ( ElementSize, Granule ), MinSize );
+        if ( exact * ElementSize <= MaxBytes or exact == MinSize )
+            return exact;
+        std::size_t best = MinSize;
+        for ( std::size_t n = MinSize; n * ElementSize <= MaxBytes; n *= 2 )
+            if ( waste_of ( n ) * ( best * ElementSize + waste_of ( best ) ) <
+                 waste_of ( best ) * ( n * ElementSize + waste_of ( n ) ) )
+                best = n;
+        return best;
+    }
+
+    public:
+    static constexpr std::size_t size     = select ( );
+    static constexpr std::size_t bytes    = size * ElementSize;
+    static constexpr std::size_t granules = ( bytes + Granule - 1 ) / Granule;
+    static constexpr std::size_t waste    = waste_of ( size );
+};
+
+// What an aligned_stack_storage_ does with a request that does not fit in the remainder of its buffer.
+enum class overflow_policy { fail, upstream, abort };
+
+// A monotonic arena of Size bytes handed out by bumping a cursor. Deallocating the top allocation rolls the cursor back, other
+// memory in the buffer is only reclaimed by reset ( ). Requests that do not fit are dealt with according to Policy, i.e. throw
+// std::bad_alloc, go to the (aligned) global operator new, or abort.
+template<std::size_t Size, std::size_t Align = alignof ( std::max_align_t ), overflow_policy Policy = overflow_policy::upstream>
 struct aligned_stack_storage_ {
 
+    static_assert ( is_power_2 ( Align ), "Template parameter 2 must be an integral value with a value a power of 2" );
+
     alignas ( Align ) char m_storage[ Size ];
+    char * m_ptr        = m_storage;
+    char * m_high_water = m_storage;
 
     public:
+    static constexpr overflow_policy policy = Policy;
+
+    aligned_stack_storage_ ( ) noexcept = default;
     aligned_stack_storage_ ( aligned_stack_storage_ const & ) = delete;
     aligned_stack_storage_ & operator= ( aligned_stack_storage_ const & ) = delete;
 
-    [[nodiscard]] char * allocate ( std::size_t n ) noexcept { return m_storage; };
-    void deallocate ( char * p, std::size_t n ) noexcept { assert ( pointer_in_buffer ( p ) ); }
+    [[nodiscard]] char * allocate ( std::size_t n, std::size_t a = Align ) {
+        if ( char * p = try_allocate ( n, a ) )
+            return p;
+        return overflow ( n, a );
+    };
+
+    // Returns nullptr, instead of applying the overflow policy, if the request does not fit.
+    [[nodiscard]] char * try_allocate ( std::size_t n, std::size_t a = Align ) noexcept {
+        assert ( is_power_2 ( a ) );
+        std::size_t const o = static_cast<std::size_t> ( -reinterpret_cast<std::uintptr_t> ( m_ptr ) & ( a - 1 ) );
+        if ( o + n <= static_cast<std::size_t> ( m_storage + Size - m_ptr ) ) {
+            char * p = m_ptr + o;
+            m_ptr    = p + n;
+            if ( m_ptr > m_high_water )
+                m_high_water = m_ptr;
+            return p;
+        }
+        return nullptr;
+    }
+
+    void deallocate ( char * p, std::size_t n, std::size_t a = Align ) noexcept {
+        if ( pointer_in_buffer ( p ) ) {
+            assert ( p + n <= m_ptr );
+            if ( p + n == m_ptr )
+                m_ptr = p;
+        }
+        else {
+            if constexpr ( Policy == overflow_policy::upstream )
+                ::operator delete ( p, std::align_val_t{ std::max ( a, Align ) } );
+            else
+                assert ( false );
+        }
+    }
+
+    void reset ( ) noexcept { m_ptr = m_storage; }
+
+    [[nodiscard]] char * data ( ) noexcept { return m_storage; }
+    [[nodiscard]] char const * data ( ) const noexcept { return m_storage; }
+
+    [[nodiscard]] static constexpr std::size_t size ( ) noexcept { return Size; }
+    [[nodiscard]] std::size_t used ( ) const noexcept { return static_cast<std::size_t> ( m_ptr - m_storage ); }
+    [[nodiscard]] std::size_t high_water ( ) const noexcept { return static_cast<std::size_t> ( m_high_water - m_storage ); }
+
+    [[nodiscard]] bool pointer_in_buffer ( char const * p ) const noexcept { return m_storage <= p and p < m_storage + Size; }
 
     private:
-    [[nodiscard]] bool pointer_in_buffer ( char * p ) const noexcept { return m_storage <= p and p <= m_storage + Size; }
+    [[nodiscard]] char * overflow ( std::size_t n, std::size_t a ) {
+        if constexpr ( Policy == overflow_policy::upstream )
+            return static_cast<char *> ( ::operator new ( n, std::align_val_t{ std::max ( a, Align ) } ) );
+        else if constexpr ( Policy == overflow_policy::fail )
+            throw std::bad_alloc ( );
+        else
+            std::abort ( );
+    }
 };
 
-template<class Type, std::size_t Size, std::size_t Align = alignof ( std::max_align_t )>
+template<class Type, std::size_t Size, std::size_t Align = alignof ( std::max_align_t ),
+         overflow_policy Policy = overflow_policy::upstream>
 class stack_allocator {
 
     public:
@@ -86,49 +206,141 @@ class stack_allocator {
 
     static auto constexpr alignment = Align;
     static auto constexpr size      = Size;
-    using storage_type              = aligned_stack_storage_<size, alignment>;
+    using storage_type              = aligned_stack_storage_<size, alignment, Policy>;
 
     private:
-    storage_type & a_;
+    storage_type * a_;
 
     public:
-    stack_allocator ( stack_allocator const & ) = delete;
+    stack_allocator ( stack_allocator const & ) noexcept = default;
 
-    stack_allocator & operator= ( stack_allocator const & ) = delete;
+    stack_allocator & operator= ( stack_allocator const & ) noexcept = default;
 
-    stack_allocator ( storage_type & a ) noexcept : a_ ( a ) {
+    stack_allocator ( storage_type & a ) noexcept : a_ ( std::addressof ( a ) ) {
         static_assert ( size % alignment == 0, "size Size needs to be a multiple of alignment Align" );
+        static_assert ( alignof ( Type ) <= alignment, "alignment Align needs to be at least the alignment of Type" );
     }
 
     template<class U>
-    stack_allocator ( const stack_allocator<U, Size, alignment> & a ) noexcept : a_ ( a.a_ ) {}
+    stack_allocator ( const stack_allocator<U, Size, alignment, Policy> & a ) noexcept : a_ ( a.a_ ) {}
 
     template<class _Up>
     struct rebind {
-        using other = stack_allocator<_Up, Size, alignment>;
+        using other = stack_allocator<_Up, Size, alignment, Policy>;
     };
 
-    Type * allocate ( std::size_t n ) { return reinterpret_cast<Type *> ( a_.allocate ( n * sizeof ( Type ) ) ); }
-    void deallocate ( Type * p, std::size_t n ) noexcept { a_.deallocate ( reinterpret_cast<char *> ( p ), n * sizeof ( Type ) ); }
+    Type * allocate ( std::size_t n ) {
+        return reinterpret_cast<Type *> ( a_->allocate ( n * sizeof ( Type ), alignof ( Type ) ) );
+    }
+    void deallocate ( Type * p, std::size_t n ) noexcept {
+        a_->deallocate ( reinterpret_cast<char *> ( p ), n * sizeof ( Type ), alignof ( Type ) );
+    }
 
-    template<std::size_t A1, class U, std::size_t M, std::size_t A2>
-    friend inline bool operator== ( stack_allocator<Type, Size, A1> const & x, stack_allocator<U, M, A2> const & y ) noexcept {
-        return Size == M && A1 == A2 && &x.a_ == &y.a_;
+    template<std::size_t A1, class U, std::size_t M, std::size_t A2, overflow_policy P>
+    friend inline bool operator== ( stack_allocator<Type, Size, A1, Policy> const & x,
+                                    stack_allocator<U, M, A2, P> const & y ) noexcept {
+        return Size == M && A1 == A2 && Policy == P && static_cast<void const *> ( x.a_ ) == static_cast<void const *> ( y.a_ );
     }
 
-    template<std::size_t A1, class U, std::size_t M, std::size_t A2>
-    friend inline bool operator!= ( stack_allocator<Type, Size, A1> const & x, stack_allocator<U, M, A2> const & y ) noexcept {
+    template<std::size_t A1, class U, std::size_t M, std::size_t A2, overflow_policy P>
+    friend inline bool operator!= ( stack_allocator<Type, Size, A1, Policy> const & x,
+                                    stack_allocator<U, M, A2, P> const & y ) noexcept {
         return !( x == y );
     }
 
-    template<class U, std::size_t M, std::size_t A>
+    template<class U, std::size_t M, std::size_t A, overflow_policy P>
     friend class stack_allocator;
 };
 
-template<typename Type, typename SizeType, std::size_t ChunkSize = 512u>
-class static_deque {
+// A std::pmr::memory_resource on top of an aligned_stack_storage_ it owns, requests that do not fit in the buffer go to the
+// upstream resource (pass std::pmr::null_memory_resource ( ) to make overflow fail).
+template<std::size_t Size, std::size_t Align = alignof ( std::max_align_t )>
+class monotonic_stack_resource : public std::pmr::memory_resource {
+
+    public:
+    using storage_type = aligned_stack_storage_<Size, Align, overflow_policy::fail>;
+
+    explicit monotonic_stack_resource ( std::pmr::memory_resource * upstream_ = std::pmr::get_default_resource ( ) ) noexcept :
+        m_upstream ( upstream_ ) {}
+
+    monotonic_stack_resource ( monotonic_stack_resource const & ) = delete;
+    monotonic_stack_resource & operator= ( monotonic_stack_resource const & ) = delete;
+
+    // Rewinds the buffer, memory obtained from upstream is not affected.
+    void release ( ) noexcept { m_storage.reset ( ); }
+
+    [[nodiscard]] storage_type const & storage ( ) const noexcept { return m_storage; }
+    [[nodiscard]] std::pmr::memory_resource * upstream_resource ( ) const noexcept { return m_upstream; }
+
+    private:
+    [[nodiscard]] void * do_allocate ( std::size_t n_, std::size_t a_ ) override {
+        if ( char * p = m_storage.try_allocate ( n_, a_ ) )
+            return p;
+        return m_upstream->allocate ( n_, a_ );
+    }
+
+    void do_deallocate ( void * p_, std::size_t n_, std::size_t a_ ) override {
+        if ( m_storage.pointer_in_buffer ( static_cast<char const *> ( p_ ) ) )
+            m_storage.deallocate ( static_cast<char *> ( p_ ), n_, a_ );
+        else
+            m_upstream->deallocate ( p_, n_, a_ );
+    }
+
+    [[nodiscard]] bool do_is_equal ( std::pmr::memory_resource const & r_ ) const noexcept override { return this == &r_; }
+
+    storage_type m_storage;
+    std::pmr::memory_resource * m_upstream;
+};
+
+// A type is trivially relocatable if moving an object to new storage and destroying the original amounts to copying its bytes,
+// i.e. the object does not point into itself and is not registered anywhere by address. That holds for all trivially copyable
+// types and for most others, f.e. a handle wrapping a std::unique_ptr, specialize is_trivially_relocatable to opt them in:
+//
+//     template<>
+//     struct is_trivially_relocatable<handle> : std::true_type {};
+template<typename Type>
+struct is_trivially_relocatable : std::is_trivially_copyable<Type> {};
+
+template<typename Type>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<Type>::value;
+
+// How a static_deque grows its chunk map and how many freed chunks it keeps around for reuse. A queue in steady state (push
+// at one end, pop at the other) frees a chunk for every chunk it allocates, the spare chunks absorb that churn.
+struct static_deque_policy {
+    // The capacity of the chunk map that replaces one of capacity c_ (0 if there is none yet), a power of 2 larger than c_.
+    [[nodiscard]] static constexpr std::size_t grow ( std::size_t c_ ) noexcept { return c_ ? 2 * c_ : 2; }
+    // The number of freed chunks that are kept, instead of being returned to the allocator.
+    static constexpr std::size_t spare_chuncks = 2;
+};
+
+// The chunk a small static_deque keeps in the object, plus the single entry chunk map that indexes it until the deque outgrows
+// it. Empty if the deque has no inline chunk.
+template<typename Type, std::size_t ChunkSize, bool Inline>
+struct static_deque_inline_ {
+    Type * m_inline_map[ 1 ];
+    alignas ( Type ) unsigned char m_inline_chunck[ ChunkSize * sizeof ( Type ) ];
+    bool m_inline_busy = false;
+};
+
+template<typename Type, std::size_t ChunkSize>
+struct static_deque_inline_<Type, ChunkSize, false> {};
+
+// A deque of fixed size chunks of ChunkSize elements (by default as many as fill whole pages, see chunk_layout), the chunks are
+// indexed through a circular chunk map. Pushing and popping at the ends never moves elements, i.e. pointers and references to
+// elements stay valid until the element is erased, inserting or erasing in the middle moves the elements on the shorter side
+// (like std::deque). The chunks and the chunk map are obtained from Allocator, f.e. a stack_allocator, which serves them from a
+// stack buffer until that is exhausted.
+// With Inline, one chunk lives in the object itself, an empty inline deque is filled from the end of that chunk it is pushed at
+// (instead of from its centre). It allocates once the elements no longer fit in the chunk, i.e. a stack of at most ChunkSize
+// elements, or a queue that is drained at least every ChunkSize pushes, does not allocate at all.
+// Moving or swapping such a deque moves the elements in the inline chunk, which invalidates pointers and iterators to them.
+template<typename Type, typename SizeType, std::size_t ChunkSize = chunk_layout<sizeof ( Type )>::size,
+         typename Allocator = std::allocator<Type>, bool Inline = false, typename Policy = static_deque_policy>
+class static_deque : private static_deque_inline_<Type, ChunkSize, Inline> {
 
     static_assert ( is_power_2 ( ChunkSize ), "Template parameter 3 must be an integral value with a value a power of 2" );
+    static_assert ( ChunkSize - 1 <= std::numeric_limits<SizeType>::max ( ),
+                    "Template parameter 3 must fit in template parameter 2" );
 
     public:
     using value_type    = Type;
@@ -140,25 +352,259 @@ class static_deque {
     using rv_reference    = value_type &&;
 
     using size_type       = SizeType;
-    using difference_type = std::make_signed<size_type>;
+    using difference_type = std::make_signed_t<size_type>;
 
-    using iterator               = pointer;
-    using const_iterator         = const_pointer;
-    using reverse_iterator       = pointer;
-    using const_reverse_iterator = const_pointer;
+    using allocator_type     = Allocator;
+    using allocator_traits   = std::allocator_traits<allocator_type>;
+    using map_allocator_type = typename allocator_traits::template rebind_alloc<pointer>;
 
-    using void_ptr = void *;
+    static_assert ( std::is_same_v<typename allocator_traits::value_type, value_type>, "Allocator::value_type must be Type" );
+    static_assert ( std::is_same_v<typename allocator_traits::pointer, pointer>, "Allocator::pointer must be a raw pointer" );
+
+    using void_ptr    = void *;
+    using map_pointer = pointer *;
 
     static constexpr size_type chunck_size = ChunkSize;
+    static constexpr bool inline_chunck    = Inline;
+
+    // The layout of a chunk, the pages it spans and the bytes it leaves unused in the last one.
+    static constexpr std::size_t chunck_bytes      = ChunkSize * sizeof ( value_type );
+    static constexpr std::size_t chunck_pages      = ( chunck_bytes + page_size - 1 ) / page_size;
+    static constexpr std::size_t chunck_page_waste = chunck_pages * page_size - chunck_bytes;
+
+    using policy_type = Policy;
+
+    // A random access iterator that tracks the chunk it points into, it is invalidated by any operation that grows the chunk
+    // map or frees a chunk. Positions are ordered by the logical chunk (relative to the front chunk) and the offset in it.
+    template<bool Const>
+    class basic_iterator {
+
+        friend class static_deque;
+        friend class basic_iterator<not Const>;
+
+        using map_type = std::conditional_t<Const, Type const * const *, Type * const *>;
+
+        public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = Type;
+        using difference_type   = static_deque::difference_type;
+        using pointer           = std::conditional_t<Const, value_type const *, value_type *>;
+        using reference         = std::conditional_t<Const, value_type const &, value_type &>;
+
+        basic_iterator ( ) noexcept = default;
+
+        template<bool C = Const, typename = std::enable_if_t<C>>
+        basic_iterator ( basic_iterator<false> const & i_ ) noexcept :
+            m_cur ( i_.m_cur ), m_first ( i_.m_first ), m_map ( i_.m_map ), m_base ( i_.m_base ), m_mask ( i_.m_mask ),
+            m_node ( i_.m_node ) {}
+
+        [[nodiscard]] reference operator* ( ) const noexcept { return *m_cur; }
+        [[nodiscard]] pointer operator-> ( ) const noexcept { return m_cur; }
+        [[nodiscard]] reference operator[] ( difference_type n_ ) const noexcept { return *( *this + n_ ); }
+
+        [[maybe_unused]] basic_iterator & operator++ ( ) noexcept {
+            if ( ++m_cur == m_first + chunck_size )
+                set_node ( m_node + 1 );
+            return *this;
+        }
+        [[maybe_unused]] basic_iterator operator++ ( int ) noexcept {
+            basic_iterator i = *this;
+            ++*this;
+            return i;
+        }
+        [[maybe_unused]] basic_iterator & operator-- ( ) noexcept {
+            if ( m_cur == m_first ) {
+                set_node ( m_node - 1 );
+                m_cur = m_first + chunck_size;
+            }
+            --m_cur;
+            return *this;
+        }
+        [[maybe_unused]] basic_iterator operator-- ( int ) noexcept {
+            basic_iterator i = *this;
+            --*this;
+            return i;
+        }
+
+        [[maybe_unused]] basic_iterator & operator+= ( difference_type n_ ) noexcept {
+            std::ptrdiff_t const o = ( m_cur - m_first ) + n_;
+            if ( o >= 0 and o < static_cast<std::ptrdiff_t> ( chunck_size ) ) {
+                m_cur += n_;
+            }
+            else {
+                set_node ( m_node + ( o >> chunck_shift ) );
+                m_cur += o & ( chunck_size - 1 );
+            }
+            return *this;
+        }
+        [[maybe_unused]] basic_iterator & operator-= ( difference_type n_ ) noexcept { return *this += -n_; }
+
+        [[nodiscard]] friend basic_iterator operator+ ( basic_iterator i_, difference_type n_ ) noexcept { return i_ += n_; }
+        [[nodiscard]] friend basic_iterator operator+ ( difference_type n_, basic_iterator i_ ) noexcept { return i_ += n_; }
+        [[nodiscard]] friend basic_iterator operator- ( basic_iterator i_, difference_type n_ ) noexcept { return i_ -= n_; }
+
+        [[nodiscard]] friend difference_type operator- ( basic_iterator const & a_, basic_iterator const & b_ ) noexcept {
+            return static_cast<difference_type> ( ( a_.m_node - b_.m_node ) * static_cast<std::ptrdiff_t> ( chunck_size ) +
+                                                  ( a_.m_cur - a_.m_first ) - ( b_.m_cur - b_.m_first ) );
+        }
+
+        [[nodiscard]] friend bool operator== ( basic_iterator const & a_, basic_iterator const & b_ ) noexcept {
+            return a_.m_cur == b_.m_cur and a_.m_node == b_.m_node;
+        }
+        [[nodiscard]] friend bool operator!= ( basic_iterator const & a_, basic_iterator const & b_ ) noexcept {
+            return not( a_ == b_ );
+        }
+        [[nodiscard]] friend bool operator< ( basic_iterator const & a_, basic_iterator const & b_ ) noexcept {
+            return ( a_ - b_ ) < 0;
+        }
+        [[nodiscard]] friend bool operator> ( basic_iterator const & a_, basic_iterator const & b_ ) noexcept { return b_ < a_; }
+        [[nodiscard]] friend bool operator<= ( basic_iterator const & a_, basic_iterator const & b_ ) noexcept {
+            return not( b_ < a_ );
+        }
+        [[nodiscard]] friend bool operator>= ( basic_iterator const & a_, basic_iterator const & b_ ) noexcept {
+            return not( a_ < b_ );
+        }
+
+        // Segmented algorithms, found through ADL, every chunk is processed as a contiguous range.
+
+        template<typename Function>
+        [[maybe_unused]] friend Function for_each ( basic_iterator f_, basic_iterator l_, Function fn_ ) {
+            for ( ; f_.m_node < l_.m_node; f_.set_node ( f_.m_node + 1 ) )
+                for ( pointer p = f_.m_cur, e = f_.m_first + chunck_size; p != e; ++p )
+                    fn_ ( *p );
+            for ( pointer p = f_.m_cur; p != l_.m_cur; ++p )
+                fn_ ( *p );
+            return fn_;
+        }
+
+        template<typename OutputIt>
+        [[maybe_unused]] friend OutputIt copy ( basic_iterator f_, basic_iterator l_, OutputIt o_ ) {
+            for ( ; f_.m_node < l_.m_node; f_.set_node ( f_.m_node + 1 ) )
+                o_ = std::copy ( f_.m_cur, f_.m_first + chunck_size, o_ );
+            return std::copy ( f_.m_cur, l_.m_cur, o_ );
+        }
+
+        template<typename U>
+        friend void fill ( basic_iterator f_, basic_iterator l_, U const & v_ ) {
+            static_assert ( not Const, "fill requires a mutable iterator" );
+            for ( ; f_.m_node < l_.m_node; f_.set_node ( f_.m_node + 1 ) )
+                std::fill ( f_.m_cur, f_.m_first + chunck_size, v_ );
+            std::fill ( f_.m_cur, l_.m_cur, v_ );
+        }
+
+        template<typename U>
+        [[nodiscard]] friend basic_iterator find ( basic_iterator f_, basic_iterator l_, U const & v_ ) {
+            for ( ; f_.m_node < l_.m_node; f_.set_node ( f_.m_node + 1 ) ) {
+                pointer const e = f_.m_first + chunck_size;
+                if ( ( f_.m_cur = std::find ( f_.m_cur, e, v_ ) ) != e )
+                    return f_;
+            }
+            f_.m_cur = std::find ( f_.m_cur, l_.m_cur, v_ );
+            return f_;
+        }
+
+        private:
+        void set_node ( std::ptrdiff_t n_ ) noexcept {
+            m_node  = n_;
+            m_first = m_map ? m_map[ ( m_base + static_cast<std::size_t> ( n_ ) ) & m_mask ] : nullptr;
+            m_cur   = m_first;
+        }
+
+        pointer m_cur = nullptr, m_first = nullptr;
+        map_type m_map = nullptr;
+        std::size_t m_base = 0, m_mask = 0;
+        std::ptrdiff_t m_node = 0;
+    };
+
+    using iterator               = basic_iterator<false>;
+    using const_iterator         = basic_iterator<true>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    explicit static_deque ( ) noexcept ( noexcept ( allocator_type ( ) ) ) = default;
+    explicit static_deque ( allocator_type const & a_ ) noexcept : m_allocator ( a_ ) {}
+
+    explicit static_deque ( size_type n_, allocator_type const & a_ = allocator_type ( ) ) : m_allocator ( a_ ) {
+        try {
+            resize ( n_ );
+        }
+        catch ( ... ) {
+            release ( );
+            throw;
+        }
+    }
+
+    static_deque ( size_type n_, const_reference v_, allocator_type const & a_ = allocator_type ( ) ) : m_allocator ( a_ ) {
+        try {
+            resize ( n_, v_ );
+        }
+        catch ( ... ) {
+            release ( );
+            throw;
+        }
+    }
 
-    explicit static_deque ( ) noexcept           = default;
-    static_deque ( static_deque const & d_ )     = default;
-    static_deque ( static_deque && d_ ) noexcept = default;
+    template<typename InputIt, typename = std::enable_if_t<std::input_iterator<InputIt>>>
+    static_deque ( InputIt f_, InputIt l_, allocator_type const & a_ = allocator_type ( ) ) : m_allocator ( a_ ) {
+        try {
+            insert_range ( 0, std::ranges::subrange ( f_, l_ ) );
+        }
+        catch ( ... ) {
+            release ( );
+            throw;
+        }
+    }
+
+    static_deque ( std::initializer_list<value_type> l_, allocator_type const & a_ = allocator_type ( ) ) :
+        static_deque ( l_.begin ( ), l_.end ( ), a_ ) {}
+
+    static_deque ( static_deque const & d_ ) :
+        static_deque ( d_, allocator_traits::select_on_container_copy_construction ( d_.m_allocator ) ) {}
+
+    static_deque ( static_deque const & d_, allocator_type const & a_ ) : m_allocator ( a_ ) {
+        try {
+            insert_range ( 0, d_ );
+        }
+        catch ( ... ) {
+            release ( );
+            throw;
+        }
+    }
 
-    [[nodiscard]] static_deque & operator= ( static_deque const & d_ ) = default;
-    [[nodiscard]] static_deque & operator= ( static_deque && d_ ) noexcept = default;
+    static_deque ( static_deque && d_ ) noexcept : m_allocator ( std::move ( d_.m_allocator ) ) { steal ( d_ ); }
 
-    ~static_deque ( ) noexcept = default;
+    [[maybe_unused]] static_deque & operator= ( static_deque const & d_ ) {
+        if ( this != std::addressof ( d_ ) ) {
+            static_deque tmp ( d_, allocator_traits::propagate_on_container_copy_assignment::value ? d_.m_allocator : m_allocator );
+            swap_all ( tmp );
+        }
+        return *this;
+    }
+
+    [[maybe_unused]] static_deque & operator= ( static_deque && d_ ) noexcept (
+        std::disjunction_v<typename allocator_traits::propagate_on_container_move_assignment,
+                           typename allocator_traits::is_always_equal> ) {
+        if constexpr ( std::disjunction_v<typename allocator_traits::propagate_on_container_move_assignment,
+                                          typename allocator_traits::is_always_equal> ) {
+            static_deque tmp ( std::move ( d_ ) );
+            swap_all ( tmp );
+        }
+        else {
+            if ( m_allocator == d_.m_allocator ) {
+                static_deque tmp ( std::move ( d_ ) );
+                swap_all ( tmp );
+            }
+            else {
+                clear ( );
+                for ( auto & e : d_ )
+                    emplace_back ( std::move ( e ) );
+                d_.clear ( );
+            }
+        }
+        return *this;
+    }
+
+    ~static_deque ( ) noexcept { release ( ); }
 
     // Sizes.
 
@@ -166,36 +612,787 @@ class static_deque {
         return std::numeric_limits<size_type>::max ( ) / sizeof ( value_type );
     }
 
-    [[nodiscard]] inline size_type capacity ( ) const noexcept { return 0; }
-    [[nodiscard]] inline size_type size ( ) const noexcept { return 0; }
+    [[nodiscard]] inline size_type capacity ( ) const noexcept { return used_chuncks ( ) * chunck_size; }
+    [[nodiscard]] inline size_type size ( ) const noexcept { return m_size; }
+
+    [[nodiscard]] bool empty ( ) const noexcept { return not m_size; }
+
+    // Element access.
+
+    [[nodiscard]] reference operator[] ( size_type i_ ) noexcept {
+        return const_cast<reference> ( std::as_const ( *this ).operator[] ( i_ ) );
+    }
+    [[nodiscard]] const_reference operator[] ( size_type i_ ) const noexcept {
+        assert ( i_ < m_size );
+        return *slot ( position ( i_ ) );
+    }
+
+    [[nodiscard]] reference at ( size_type i_ ) { return const_cast<reference> ( std::as_const ( *this ).at ( i_ ) ); }
+    [[nodiscard]] const_reference at ( size_type i_ ) const {
+        if ( i_ >= m_size )
+            throw std::out_of_range ( "static_deque: index out of range" );
+        return operator[] ( i_ );
+    }
+
+    [[nodiscard]] reference front ( ) noexcept { return operator[] ( 0 ); }
+    [[nodiscard]] const_reference front ( ) const noexcept { return operator[] ( 0 ); }
+    [[nodiscard]] reference back ( ) noexcept { return operator[] ( m_size - 1 ); }
+    [[nodiscard]] const_reference back ( ) const noexcept { return operator[] ( m_size - 1 ); }
+
+    // Iterators.
+
+    [[nodiscard]] iterator begin ( ) noexcept { return make_iterator<false> ( 0 ); }
+    [[nodiscard]] const_iterator begin ( ) const noexcept { return make_iterator<true> ( 0 ); }
+    [[nodiscard]] const_iterator cbegin ( ) const noexcept { return begin ( ); }
+    [[nodiscard]] iterator end ( ) noexcept { return make_iterator<false> ( m_size ); }
+    [[nodiscard]] const_iterator end ( ) const noexcept { return make_iterator<true> ( m_size ); }
+    [[nodiscard]] const_iterator cend ( ) const noexcept { return end ( ); }
+
+    [[nodiscard]] reverse_iterator rbegin ( ) noexcept { return reverse_iterator ( end ( ) ); }
+    [[nodiscard]] const_reverse_iterator rbegin ( ) const noexcept { return const_reverse_iterator ( end ( ) ); }
+    [[nodiscard]] const_reverse_iterator crbegin ( ) const noexcept { return rbegin ( ); }
+    [[nodiscard]] reverse_iterator rend ( ) noexcept { return reverse_iterator ( begin ( ) ); }
+    [[nodiscard]] const_reverse_iterator rend ( ) const noexcept { return const_reverse_iterator ( begin ( ) ); }
+    [[nodiscard]] const_reverse_iterator crend ( ) const noexcept { return rend ( ); }
+
+    // Modifiers.
+
+    template<typename... Args>
+    [[maybe_unused]] reference emplace_back ( Args &&... args_ ) {
+        if ( not m_map )
+            init_map ( );
+        if constexpr ( Inline ) {
+            if ( not m_size )
+                m_front = static_cast<size_type> ( m_front - offset_of ( m_front ) );
+        }
+        size_type p      = position ( m_size );
+        bool const fresh = m_size and not offset_of ( p );
+        if ( fresh ) {
+            if ( used_chuncks ( ) == m_map_capacity ) {
+                grow_map ( );
+                p = position ( m_size );
+            }
+            m_map[ chunk_of ( p ) ] = allocate_chunck ( );
+        }
+        pointer e = construct ( p, fresh, std::forward<Args> ( args_ )... );
+        ++m_size;
+        return *e;
+    }
+
+    template<typename... Args>
+    [[maybe_unused]] reference emplace_front ( Args &&... args_ ) {
+        if ( not m_map )
+            init_map ( );
+        if ( not m_size ) {
+            if constexpr ( Inline )
+                m_front = static_cast<size_type> ( m_front | ( chunck_size - 1 ) );
+            pointer e = construct ( m_front, false, std::forward<Args> ( args_ )... );
+            ++m_size;
+            return *e;
+        }
+        bool const fresh = not offset_of ( m_front );
+        if ( fresh and used_chuncks ( ) == m_map_capacity )
+            grow_map ( );
+        size_type const p = static_cast<size_type> ( ( m_front - 1 ) & mask ( ) );
+        if ( fresh )
+            m_map[ chunk_of ( p ) ] = allocate_chunck ( );
+        pointer e = construct ( p, fresh, std::forward<Args> ( args_ )... );
+        m_front   = p;
+        ++m_size;
+        return *e;
+    }
 
-    [[nodiscard]] bool empty ( ) const noexcept { return true; }
+    void push_back ( const_reference v_ ) { emplace_back ( v_ ); }
+    void push_back ( rv_reference v_ ) { emplace_back ( std::move ( v_ ) ); }
+    void push_front ( const_reference v_ ) { emplace_front ( v_ ); }
+    void push_front ( rv_reference v_ ) { emplace_front ( std::move ( v_ ) ); }
+
+    void pop_back ( ) noexcept {
+        assert ( m_size );
+        size_type const p = position ( m_size - 1 );
+        slot ( p )->~value_type ( );
+        if ( --m_size ) {
+            if ( not offset_of ( p ) )
+                release_chunck ( chunk_of ( p ) );
+        }
+        else {
+            m_front = centre_of ( p );
+        }
+    }
+
+    void pop_front ( ) noexcept {
+        assert ( m_size );
+        size_type const p = m_front;
+        slot ( p )->~value_type ( );
+        if ( --m_size ) {
+            m_front = static_cast<size_type> ( ( p + 1 ) & mask ( ) );
+            if ( not offset_of ( m_front ) )
+                release_chunck ( chunk_of ( p ) );
+        }
+        else {
+            m_front = centre_of ( p );
+        }
+    }
+
+    // Bulk modifiers, these allocate, fill and free a chunk at a time (with memcpy if Type is trivially copyable and the source
+    // is contiguous). In the middle, the elements on the shorter side of the position are moved to make room or to close the gap.
+
+    template<typename Range>
+    void append_range ( Range && r_ ) {
+        insert_range ( m_size, std::forward<Range> ( r_ ) );
+    }
+    template<typename Range>
+    void prepend_range ( Range && r_ ) {
+        insert_range ( 0, std::forward<Range> ( r_ ) );
+    }
+
+    template<typename... Args>
+    [[maybe_unused]] iterator emplace ( const_iterator p_, Args &&... args_ ) {
+        size_type const i = index_of ( p_ );
+        if ( i == m_size ) {
+            emplace_back ( std::forward<Args> ( args_ )... );
+        }
+        else if ( not i ) {
+            emplace_front ( std::forward<Args> ( args_ )... );
+        }
+        else {
+            value_type v ( std::forward<Args> ( args_ )... );
+            auto f = std::make_move_iterator ( std::addressof ( v ) );
+            insert_n ( i, 1, copy_from ( f ) );
+        }
+        return begin ( ) + static_cast<difference_type> ( i );
+    }
+
+    [[maybe_unused]] iterator insert ( const_iterator p_, const_reference v_ ) { return emplace ( p_, v_ ); }
+    [[maybe_unused]] iterator insert ( const_iterator p_, rv_reference v_ ) { return emplace ( p_, std::move ( v_ ) ); }
+
+    [[maybe_unused]] iterator insert ( const_iterator p_, size_type n_, const_reference v_ ) {
+        size_type const i = index_of ( p_ );
+        if ( n_ ) {
+            value_type const v ( v_ ); // v_ might be an element that is moved.
+            insert_n ( i, n_, [ &v ] ( pointer d_, size_type k_ ) { std::uninitialized_fill_n ( d_, k_, v ); } );
+        }
+        return begin ( ) + static_cast<difference_type> ( i );
+    }
+
+    template<typename InputIt, typename = std::enable_if_t<std::input_iterator<InputIt>>>
+    [[maybe_unused]] iterator insert ( const_iterator p_, InputIt f_, InputIt l_ ) {
+        size_type const i = index_of ( p_ );
+        insert_range ( i, std::ranges::subrange ( f_, l_ ) );
+        return begin ( ) + static_cast<difference_type> ( i );
+    }
+
+    [[maybe_unused]] iterator insert ( const_iterator p_, std::initializer_list<value_type> l_ ) {
+        return insert ( p_, l_.begin ( ), l_.end ( ) );
+    }
+
+    [[maybe_unused]] iterator erase ( const_iterator p_ ) { return erase ( p_, std::next ( p_ ) ); }
+    [[maybe_unused]] iterator erase ( const_iterator f_, const_iterator l_ ) {
+        size_type const i = index_of ( f_ );
+        erase_n ( i, static_cast<size_type> ( l_ - f_ ) );
+        return begin ( ) + static_cast<difference_type> ( i );
+    }
+
+    // New elements are value-initialized, or copies of v_.
+    void resize ( size_type n_ ) {
+        if ( n_ < m_size )
+            erase_n ( n_, m_size - n_ );
+        else
+            insert_n ( m_size, n_ - m_size, [] ( pointer d_, size_type k_ ) { std::uninitialized_value_construct_n ( d_, k_ ); } );
+    }
+    void resize ( size_type n_, const_reference v_ ) {
+        if ( n_ < m_size )
+            erase_n ( n_, m_size - n_ );
+        else
+            insert_n ( m_size, n_ - m_size, [ &v_ ] ( pointer d_, size_type k_ ) { std::uninitialized_fill_n ( d_, k_, v_ ); } );
+    }
+
+    // Destroys all elements, the chunk holding the front is retained.
+    void clear ( ) noexcept {
+        if ( not m_size )
+            return;
+        destroy_segments ( m_front, m_size );
+        size_type const u = used_chuncks ( ), f = chunk_of ( m_front );
+        for ( size_type i = 1; i < u; ++i )
+            release_chunck ( ( f + i ) & ( m_map_capacity - 1 ) );
+        m_size  = 0;
+        m_front = centre_of ( m_front );
+    }
+
+    // Returns the spare chunks to the allocator and shrinks the chunk map to the smallest capacity (following the policy) that
+    // holds the used chunks, an empty deque gives up all its storage.
+    void shrink_to_fit ( ) {
+        release_spares ( );
+        if ( not m_map )
+            return;
+        if ( not m_size ) {
+            release ( );
+            return;
+        }
+        size_type const u = used_chuncks ( );
+        if constexpr ( Inline ) {
+            if ( u == 1 ) {
+                if ( not is_inline_map ( ) )
+                    relocate_map ( this->m_inline_map, 1 );
+                return;
+            }
+        }
+        std::size_t c = Policy::grow ( 0 );
+        while ( c < u )
+            c = Policy::grow ( c );
+        if ( c < m_map_capacity )
+            relocate_map ( allocate_map ( static_cast<size_type> ( c ) ), static_cast<size_type> ( c ) );
+    }
+
+    void swap ( static_deque & d_ ) noexcept {
+        if constexpr ( allocator_traits::propagate_on_container_swap::value )
+            std::swap ( m_allocator, d_.m_allocator );
+        else
+            assert ( m_allocator == d_.m_allocator );
+        swap_storage ( d_ );
+    }
+
+    friend void swap ( static_deque & a_, static_deque & b_ ) noexcept { a_.swap ( b_ ); }
+
+    [[nodiscard]] allocator_type get_allocator ( ) const noexcept { return m_allocator; }
 
     // Output.
 
     template<typename Stream>
     [[maybe_unused]] friend Stream & operator<< ( Stream & out_, static_deque const & d_ ) noexcept {
-        //  if ( d_.data ( ) )
-        //     for ( auto const & e : d_ )
-        //        out_ << e << sp; // A wide- or narrow-string space, as appropriate.
+        for ( auto const & e : d_ )
+            out_ << e << sp; // A wide- or narrow-string space, as appropriate.
         return out_;
     }
 
     private:
-    [[maybe_unused]] size_type grow_capacity ( ) noexcept {
-        /*
-        size_type c = capacity ( );
-        if ( c > 1 ) {
-            c                = c + c / 2;
-            capacity_ref ( ) = c;
-            return c;
+    static constexpr int chunck_shift = log_power_2 ( ChunkSize );
+
+    // Positions index the (circular) space of m_map_capacity * chunck_size slots.
+
+    [[nodiscard]] size_type mask ( ) const noexcept { return static_cast<size_type> ( m_map_capacity * chunck_size - 1 ); }
+    [[nodiscard]] size_type wrap ( std::size_t p_ ) const noexcept { return static_cast<size_type> ( p_ & mask ( ) ); }
+    [[nodiscard]] size_type position ( size_type i_ ) const noexcept { return wrap ( std::size_t{ m_front } + i_ ); }
+
+    [[nodiscard]] static constexpr size_type chunk_of ( size_type p_ ) noexcept {
+        return static_cast<size_type> ( p_ >> chunck_shift );
+    }
+    [[nodiscard]] static constexpr size_type offset_of ( size_type p_ ) noexcept {
+        return static_cast<size_type> ( p_ & ( chunck_size - 1 ) );
+    }
+    [[nodiscard]] static constexpr size_type centre_of ( size_type p_ ) noexcept {
+        return static_cast<size_type> ( ( p_ - offset_of ( p_ ) ) | ( chunck_size >> 1 ) );
+    }
+
+    [[nodiscard]] pointer slot ( size_type p_ ) const noexcept { return m_map[ chunk_of ( p_ ) ] + offset_of ( p_ ); }
+
+    template<bool Const>
+    [[nodiscard]] basic_iterator<Const> make_iterator ( std::size_t i_ ) const noexcept {
+        basic_iterator<Const> i;
+        std::size_t const l = offset_of ( m_front ) + i_;
+        i.m_map             = m_map;
+        i.m_base            = chunk_of ( m_front );
+        i.m_mask            = m_map_capacity ? m_map_capacity - 1u : 0u;
+        i.set_node ( static_cast<std::ptrdiff_t> ( l >> chunck_shift ) );
+        i.m_cur += l & ( chunck_size - 1 );
+        return i;
+    }
+
+    // The chunks [ chunk_of ( m_front ), chunk_of ( back ) ] are allocated, all others are nullptr. An empty deque retains the
+    // chunk holding m_front, the front and the back never share a chunk.
+    [[nodiscard]] size_type used_chuncks ( ) const noexcept {
+        if ( not m_map )
+            return 0;
+        if ( not m_size )
+            return 1;
+        return static_cast<size_type> (
+            ( ( chunk_of ( position ( m_size - 1 ) ) - chunk_of ( m_front ) ) & ( m_map_capacity - 1 ) ) + 1 );
+    }
+
+    template<typename... Args>
+    [[nodiscard]] pointer construct ( size_type p_, bool fresh_, Args &&... args_ ) {
+        pointer e = slot ( p_ );
+        try {
+            ::new ( static_cast<void_ptr> ( e ) ) value_type ( std::forward<Args> ( args_ )... );
+        }
+        catch ( ... ) {
+            if ( fresh_ )
+                release_chunck ( chunk_of ( p_ ) );
+            throw;
+        }
+        return e;
+    }
+
+    // Relocating (moving, then destroying the source) Type can not fail, which makes a middle insert or erase a matter of moving
+    // the elements on one side over the gap. If it can fail, std::rotate and std::move do the work, with the basic guarantee.
+    // Trivially relocatable elements are relocated with memmove.
+    static constexpr bool trivial_relocate = is_trivially_relocatable_v<value_type>;
+    static constexpr bool nothrow_relocate = trivial_relocate or std::is_nothrow_move_constructible_v<value_type>;
+
+    [[nodiscard]] size_type index_of ( const_iterator p_ ) const noexcept { return static_cast<size_type> ( p_ - cbegin ( ) ); }
+
+    // A fill (see construct_segments) that copies from f_, or moves if f_ is a move_iterator, f_ is advanced past the copies.
+    template<typename InputIt>
+    [[nodiscard]] static auto copy_from ( InputIt & f_ ) noexcept {
+        return [ &f_ ] ( pointer d_, size_type k_ ) {
+            if constexpr ( std::conjunction_v<std::is_trivially_copyable<value_type>,
+                                              std::is_same<std::iter_value_t<InputIt>, value_type>> and
+                           std::contiguous_iterator<InputIt> ) {
+                std::memcpy ( static_cast<void_ptr> ( d_ ), std::to_address ( f_ ), k_ * sizeof ( value_type ) );
+                f_ += k_;
+            }
+            else if constexpr ( std::conjunction_v<std::is_trivially_copyable<value_type>,
+                                                   std::disjunction<std::is_same<InputIt, iterator>,
+                                                                    std::is_same<InputIt, const_iterator>>> ) {
+                InputIt const l = f_ + static_cast<difference_type> ( k_ );
+                copy ( f_, l, d_ ); // Segmented, a chunk at a time.
+                f_ = l;
+            }
+            else {
+                size_type i = 0;
+                try {
+                    for ( ; i < k_; ++i, ++f_ )
+                        ::new ( static_cast<void_ptr> ( d_ + i ) ) value_type ( *f_ );
+                }
+                catch ( ... ) {
+                    std::destroy_n ( d_, i );
+                    throw;
+                }
+            }
+        };
+    }
+
+    template<typename Range>
+    void insert_range ( size_type i_, Range && r_ ) {
+        if constexpr ( std::disjunction_v<std::bool_constant<std::ranges::forward_range<Range>>,
+                                          std::bool_constant<std::ranges::sized_range<Range>>> ) {
+            auto const n = std::ranges::distance ( r_ );
+            if ( static_cast<std::size_t> ( n ) > static_cast<std::size_t> ( max_size ( ) - m_size ) )
+                throw std::length_error ( "static_deque: size exceeds size_type" );
+            auto f = std::ranges::begin ( r_ );
+            insert_n ( i_, static_cast<size_type> ( n ), copy_from ( f ) );
         }
         else {
-            capacity_ref ( ) = 2;
-            return 2;
+            // A single pass range, buffer it to learn its size.
+            static_deque t ( m_allocator );
+            for ( auto && e : r_ )
+                t.emplace_back ( std::forward<decltype ( e )> ( e ) );
+            auto f = std::make_move_iterator ( t.begin ( ) );
+            insert_n ( i_, t.m_size, copy_from ( f ) );
         }
-        */
     }
 
-    constexpr pointer allocate ( size_type n_ ) noexcept {}
+    // Inserts n_ elements, constructed by fill_, before element i_, all or nothing (unless relocating Type can fail).
+    template<typename Fill>
+    void insert_n ( size_type i_, size_type n_, Fill fill_ ) {
+        if ( not n_ )
+            return;
+        if ( n_ > max_size ( ) - m_size )
+            throw std::length_error ( "static_deque: size exceeds size_type" );
+        if constexpr ( not nothrow_relocate ) {
+            if ( i_ and i_ != m_size ) {
+                size_type const s = m_size;
+                if ( i_ < m_size - i_ ) {
+                    insert_n ( 0, n_, fill_ );
+                    std::rotate ( begin ( ), begin ( ) + static_cast<difference_type> ( n_ ),
+                                  begin ( ) + static_cast<difference_type> ( n_ + i_ ) );
+                }
+                else {
+                    insert_n ( m_size, n_, fill_ );
+                    std::rotate ( begin ( ) + static_cast<difference_type> ( i_ ), begin ( ) + static_cast<difference_type> ( s ),
+                                  end ( ) );
+                }
+                return;
+            }
+        }
+        if ( i_ < m_size - i_ ) {
+            size_type const p = open ( true, n_ ), f = m_front;
+            relocate ( f, p, i_, true );
+            try {
+                construct_segments ( wrap ( p + i_ ), n_, fill_ );
+            }
+            catch ( ... ) {
+                relocate ( p, f, i_, false );
+                close ( p, n_ );
+                throw;
+            }
+            m_front = p;
+        }
+        else {
+            size_type const p = open ( false, n_ ), q = position ( i_ ), b = m_size - i_;
+            relocate ( q, wrap ( q + n_ ), b, false );
+            try {
+                construct_segments ( q, n_, fill_ );
+            }
+            catch ( ... ) {
+                relocate ( wrap ( q + n_ ), q, b, true );
+                close ( p, n_ );
+                throw;
+            }
+        }
+        m_size += n_;
+    }
+
+    // Erases the n_ elements from element i_ on, the chunks that end up empty are freed.
+    void erase_n ( size_type i_, size_type n_ ) noexcept ( nothrow_relocate ) {
+        if ( not n_ )
+            return;
+        if ( n_ == m_size ) {
+            clear ( );
+            return;
+        }
+        size_type const b = m_size - i_ - n_;
+        if constexpr ( not nothrow_relocate ) {
+            if ( i_ < b ) {
+                std::move_backward ( begin ( ), begin ( ) + static_cast<difference_type> ( i_ ),
+                                     begin ( ) + static_cast<difference_type> ( i_ + n_ ) );
+                for ( size_type k = 0; k < n_; ++k )
+                    pop_front ( );
+            }
+            else {
+                std::move ( begin ( ) + static_cast<difference_type> ( i_ + n_ ), end ( ),
+                            begin ( ) + static_cast<difference_type> ( i_ ) );
+                for ( size_type k = 0; k < n_; ++k )
+                    pop_back ( );
+            }
+        }
+        else {
+            destroy_segments ( position ( i_ ), n_ );
+            if ( i_ < b ) {
+                size_type const f = m_front, t = wrap ( f + n_ );
+                relocate ( f, t, i_, false );
+                release_chuncks ( chunk_of ( f ),
+                                  static_cast<size_type> ( ( chunk_of ( t ) - chunk_of ( f ) ) & ( m_map_capacity - 1 ) ) );
+                m_front = t;
+            }
+            else {
+                relocate ( position ( i_ + n_ ), position ( i_ ), b, true );
+                size_type const l = chunk_of ( position ( m_size - n_ - 1 ) ), e = chunk_of ( position ( m_size - 1 ) );
+                release_chuncks ( static_cast<size_type> ( ( l + 1 ) & ( m_map_capacity - 1 ) ),
+                                  static_cast<size_type> ( ( e - l ) & ( m_map_capacity - 1 ) ) );
+            }
+            m_size -= n_;
+        }
+    }
+
+    // Allocates the chunks for n_ slots before the front (or after the back), the elements stay where they are. Returns the
+    // position of the first of those slots.
+    [[nodiscard]] size_type open ( bool front_, size_type n_ ) {
+        if ( not m_map )
+            init_map ( );
+        if constexpr ( Inline ) {
+            if ( not m_size )
+                m_front = static_cast<size_type> ( m_front - offset_of ( m_front ) );
+        }
+        std::size_t const o = offset_of ( m_front );
+        reserve_chuncks ( front_ ? used_chuncks ( ) + ( n_ > o ? ( n_ - o + chunck_size - 1 ) >> chunck_shift : 0u )
+                                 : ( o + m_size + n_ + chunck_size - 1 ) >> chunck_shift );
+        size_type const p = front_ ? wrap ( m_front - n_ ) : position ( m_size ), l = chunk_of ( wrap ( p + n_ - 1 ) );
+        try {
+            for ( size_type c = chunk_of ( p );; c = static_cast<size_type> ( ( c + 1 ) & ( m_map_capacity - 1 ) ) ) {
+                if ( not m_map[ c ] )
+                    m_map[ c ] = allocate_chunck ( );
+                if ( c == l )
+                    break;
+            }
+        }
+        catch ( ... ) {
+            close ( p, n_ );
+            throw;
+        }
+        return p;
+    }
+
+    // Frees the chunks allocated by open ( ) for the n_ slots from p_ on, i.e. the ones that hold no elements.
+    void close ( size_type p_, size_type n_ ) noexcept {
+        size_type const f = chunk_of ( m_front ), b = m_size ? chunk_of ( position ( m_size - 1 ) ) : f;
+        size_type const l = chunk_of ( wrap ( p_ + n_ - 1 ) );
+        for ( size_type c = chunk_of ( p_ );; c = static_cast<size_type> ( ( c + 1 ) & ( m_map_capacity - 1 ) ) ) {
+            if ( m_map[ c ] and c != f and c != b )
+                release_chunck ( c );
+            if ( c == l )
+                break;
+        }
+    }
+
+    // Constructs n_ elements from position p_ on, a segment (the part in one chunk) at a time with fill_ ( slot, count ), which
+    // constructs all count elements or none. If it throws, the elements constructed before are destroyed.
+    template<typename Fill>
+    void construct_segments ( size_type p_, size_type n_, Fill & fill_ ) {
+        size_type d = 0;
+        try {
+            while ( d < n_ ) {
+                size_type const q = wrap ( p_ + d ), k = std::min<size_type> ( n_ - d, chunck_size - offset_of ( q ) );
+                fill_ ( slot ( q ), k );
+                d += k;
+            }
+        }
+        catch ( ... ) {
+            destroy_segments ( p_, d );
+            throw;
+        }
+    }
+
+    void destroy_segments ( size_type p_, size_type n_ ) noexcept {
+        if constexpr ( not std::is_trivially_destructible_v<value_type> ) {
+            while ( n_ ) {
+                size_type const k = std::min<size_type> ( n_, chunck_size - offset_of ( p_ ) );
+                std::destroy_n ( slot ( p_ ), k );
+                p_ = wrap ( p_ + k );
+                n_ -= k;
+            }
+        }
+    }
+
+    // Moves the n_ elements from position from_ on to the (raw) slots from position to_ on, the source slots end up raw. The
+    // ranges may overlap if the direction is right, i.e. ascending if to_ comes before from_.
+    void relocate ( size_type from_, size_type to_, size_type n_, bool ascending_ ) noexcept {
+        while ( n_ ) {
+            size_type s = from_, t = to_, k;
+            if ( ascending_ ) {
+                k     = std::min<size_type> ( { n_, static_cast<size_type> ( chunck_size - offset_of ( s ) ),
+                                            static_cast<size_type> ( chunck_size - offset_of ( t ) ) } );
+                from_ = wrap ( from_ + k );
+                to_   = wrap ( to_ + k );
+            }
+            else {
+                s = wrap ( from_ + n_ - 1 );
+                t = wrap ( to_ + n_ - 1 );
+                k = std::min<size_type> (
+                    { n_, static_cast<size_type> ( offset_of ( s ) + 1 ), static_cast<size_type> ( offset_of ( t ) + 1 ) } );
+                s = wrap ( s - k + 1 );
+                t = wrap ( t - k + 1 );
+            }
+            relocate_segment ( slot ( s ), slot ( t ), k, ascending_ );
+            n_ -= k;
+        }
+    }
+
+    static void relocate_segment ( pointer s_, pointer t_, size_type k_, bool ascending_ ) noexcept {
+        if constexpr ( trivial_relocate ) {
+            std::memmove ( static_cast<void_ptr> ( t_ ), static_cast<void const *> ( s_ ), k_ * sizeof ( value_type ) );
+        }
+        else {
+            auto move = [ s_, t_ ] ( size_type i_ ) {
+                ::new ( static_cast<void_ptr> ( t_ + i_ ) ) value_type ( std::move ( s_[ i_ ] ) );
+                s_[ i_ ].~value_type ( );
+            };
+            if ( ascending_ )
+                for ( size_type i = 0; i < k_; ++i )
+                    move ( i );
+            else
+                for ( size_type i = k_; i--; )
+                    move ( i );
+        }
+    }
+
+    void init_map ( ) {
+        if constexpr ( Inline ) {
+            this->m_inline_map[ 0 ] = allocate_chunck ( );
+            m_map                   = this->m_inline_map;
+            m_map_capacity          = 1;
+            m_front                 = centre_of ( 0 );
+            return;
+        }
+        size_type const c = grow_capacity ( 0 );
+        m_map             = allocate_map ( c );
+        try {
+            m_map[ 0 ] = allocate_chunck ( );
+        }
+        catch ( ... ) {
+            deallocate_map ( m_map, c );
+            m_map = nullptr;
+            throw;
+        }
+        m_map_capacity = c;
+        m_front        = centre_of ( 0 );
+    }
+
+    void grow_map ( ) {
+        size_type const c = grow_capacity ( m_map_capacity );
+        relocate_map ( allocate_map ( c ), c );
+    }
+
+    // Grows the chunk map (once) to hold at least u_ used chunks.
+    void reserve_chuncks ( std::size_t u_ ) {
+        if ( u_ <= m_map_capacity )
+            return;
+        size_type c = m_map_capacity;
+        while ( c < u_ )
+            c = grow_capacity ( c );
+        relocate_map ( allocate_map ( c ), c );
+    }
+
+    // Relocates the chunk pointers (not the elements) to the map m_ of capacity c_, the front chunk ends up at index 0.
+    void relocate_map ( map_pointer m_, size_type c_ ) noexcept {
+        size_type const u = used_chuncks ( ), f = chunk_of ( m_front ), h = std::min<size_type> ( u, m_map_capacity - f );
+        std::copy_n ( m_map + f, h, m_ );
+        std::copy_n ( m_map, u - h, m_ + h );
+        if ( not is_inline_map ( ) )
+            deallocate_map ( m_map, m_map_capacity );
+        m_map          = m_;
+        m_map_capacity = c_;
+        m_front        = offset_of ( m_front );
+    }
+
+    void release_chunck ( size_type c_ ) noexcept {
+        deallocate_chunck ( m_map[ c_ ] );
+        m_map[ c_ ] = nullptr;
+    }
+
+    // Releases the n_ chunks from chunk c_ on.
+    void release_chuncks ( size_type c_, size_type n_ ) noexcept {
+        for ( ; n_; --n_, c_ = static_cast<size_type> ( ( c_ + 1 ) & ( m_map_capacity - 1 ) ) )
+            release_chunck ( c_ );
+    }
+
+    void release ( ) noexcept {
+        if ( not m_map )
+            return;
+        destroy_segments ( m_front, m_size );
+        for ( size_type i = 0; i < m_map_capacity; ++i )
+            if ( m_map[ i ] )
+                deallocate_chunck ( m_map[ i ] );
+        if ( not is_inline_map ( ) )
+            deallocate_map ( m_map, m_map_capacity );
+        release_spares ( );
+        m_map          = nullptr;
+        m_map_capacity = m_front = m_size = 0;
+    }
+
+    // Grows the chunk map (the inline map has a single entry) as the policy says, the number of positions is bounded by half the
+    // range of size_type.
+    [[nodiscard]] static size_type grow_capacity ( size_type c_ ) {
+        std::size_t const c = Policy::grow ( c_ );
+        assert ( is_power_2 ( c ) and c > c_ );
+        if ( c > ( std::numeric_limits<size_type>::max ( ) >> chunck_shift ) / 2 + 1 )
+            throw std::length_error ( "static_deque: size exceeds size_type" );
+        return static_cast<size_type> ( c );
+    }
+
+    [[nodiscard]] pointer allocate ( size_type n_ ) { return allocator_traits::allocate ( m_allocator, n_ ); }
+    void deallocate ( pointer p_, size_type n_ ) noexcept { allocator_traits::deallocate ( m_allocator, p_, n_ ); }
+
+    // The inline chunk, if there is one and it is free, otherwise a spare chunk, otherwise a chunk from the allocator.
+    [[nodiscard]] pointer allocate_chunck ( ) {
+        if constexpr ( Inline ) {
+            if ( not this->m_inline_busy ) {
+                this->m_inline_busy = true;
+                return inline_chunck_data ( );
+            }
+        }
+        if ( m_spares )
+            return m_spare[ --m_spares ];
+        return allocate ( chunck_size );
+    }
+    void deallocate_chunck ( pointer p_ ) noexcept {
+        if constexpr ( Inline ) {
+            if ( p_ == inline_chunck_data ( ) ) {
+                this->m_inline_busy = false;
+                return;
+            }
+        }
+        if ( m_spares < Policy::spare_chuncks )
+            m_spare[ m_spares++ ] = p_;
+        else
+            deallocate ( p_, chunck_size );
+    }
+
+    void release_spares ( ) noexcept {
+        while ( m_spares )
+            deallocate ( m_spare[ --m_spares ], chunck_size );
+    }
+
+    [[nodiscard]] pointer inline_chunck_data ( ) noexcept { return reinterpret_cast<pointer> ( this->m_inline_chunck ); }
+
+    [[nodiscard]] bool is_inline_map ( ) const noexcept {
+        if constexpr ( Inline )
+            return m_map == this->m_inline_map;
+        else
+            return false;
+    }
+
+    [[nodiscard]] map_pointer allocate_map ( size_type n_ ) {
+        map_allocator_type a ( m_allocator );
+        map_pointer m = std::allocator_traits<map_allocator_type>::allocate ( a, n_ );
+        std::fill_n ( m, n_, nullptr );
+        return m;
+    }
+    void deallocate_map ( map_pointer p_, size_type n_ ) noexcept {
+        map_allocator_type a ( m_allocator );
+        std::allocator_traits<map_allocator_type>::deallocate ( a, p_, n_ );
+    }
+
+    // Takes over the storage of d_, which is left without any, *this must not have any storage either. The elements in the
+    // inline chunk of d_ (if in use) are moved to the inline chunk of *this.
+    void steal ( static_deque & d_ ) noexcept {
+        m_map          = std::exchange ( d_.m_map, nullptr );
+        m_map_capacity = std::exchange ( d_.m_map_capacity, 0 );
+        m_front        = std::exchange ( d_.m_front, 0 );
+        m_size         = std::exchange ( d_.m_size, 0 );
+        m_spare        = d_.m_spare;
+        m_spares       = std::exchange ( d_.m_spares, 0 );
+        if constexpr ( Inline ) {
+            static_assert ( nothrow_relocate, "Moving a static_deque with an inline chunck requires a nothrow move constructible "
+                                              "or trivially relocatable Type" );
+            assert ( not this->m_inline_busy );
+            if ( m_map == d_.m_inline_map ) {
+                this->m_inline_map[ 0 ] = d_.m_inline_map[ 0 ];
+                m_map                   = this->m_inline_map;
+            }
+            if ( not d_.m_inline_busy )
+                return;
+            pointer const s = d_.inline_chunck_data ( ), t = inline_chunck_data ( );
+            size_type c = 0;
+            while ( m_map[ c ] != s )
+                ++c;
+            // The elements [ b, e ) are the ones in logical chunk k, they are consecutive in the chunk.
+            std::size_t const k = ( c - chunk_of ( m_front ) ) & ( m_map_capacity - 1u ), o = offset_of ( m_front );
+            std::size_t const b = std::max ( k * chunck_size, o ) - o, e = std::min ( ( k + 1 ) * chunck_size, o + m_size ) - o;
+            if ( b < e ) {
+                size_type const f = offset_of ( position ( static_cast<size_type> ( b ) ) );
+                relocate_segment ( s + f, t + f, static_cast<size_type> ( e - b ), true );
+            }
+            m_map[ c ]          = t;
+            this->m_inline_busy = true;
+            d_.m_inline_busy    = false;
+        }
+    }
+
+    void swap_storage ( static_deque & d_ ) noexcept {
+        if constexpr ( Inline ) {
+            static_deque t ( m_allocator );
+            t.steal ( *this );
+            steal ( d_ );
+            d_.steal ( t );
+        }
+        else {
+            std::swap ( m_map, d_.m_map );
+            std::swap ( m_map_capacity, d_.m_map_capacity );
+            std::swap ( m_front, d_.m_front );
+            std::swap ( m_size, d_.m_size );
+            std::swap ( m_spare, d_.m_spare );
+            std::swap ( m_spares, d_.m_spares );
+        }
+    }
+
+    void swap_all ( static_deque & d_ ) noexcept {
+        std::swap ( m_allocator, d_.m_allocator );
+        swap_storage ( d_ );
+    }
+
+    allocator_type m_allocator;
+    map_pointer m_map          = nullptr;
+    size_type m_map_capacity   = 0;
+    size_type m_front = 0, m_size = 0;
+    std::array<pointer, Policy::spare_chuncks> m_spare{ };
+    size_type m_spares = 0;
 };
+
+template<typename Type, typename SizeType, std::size_t ChunkSize = chunk_layout<sizeof ( Type )>::size>
+using pmr_static_deque = static_deque<Type, SizeType, ChunkSize, std::pmr::polymorphic_allocator<Type>>;
+
+// A static_deque that holds its first InlineSize elements in the object, the chunk map and further chunks (also of InlineSize
+// elements) are only allocated once it outgrows that.
+template<typename Type, typename SizeType, std::size_t InlineSize = 32u, typename Allocator = std::allocator<Type>>
+using small_static_deque = static_deque<Type, SizeType, InlineSize, Allocator, true>;
@@ -3,6 +3,10 @@
 
 #include <stddef.h>
 
+#if !defined( _MSC_VER ) && !defined( __cdecl )
+#define __cdecl
+#endif
+
 /* destruct the element pointed to by `buf` */
 typedef void (*trie_dtorcb_t)(void *buf, void *userp);
 
@@ -12,6 +16,10 @@ typedef void (*trie_itercb_t)(const char *key, void *buf, void *userp);
 typedef void *( __cdecl * trie_xalloc_t)(size_t size);
 typedef void ( __cdecl * trie_xdealloc_t)(void *ptr);
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* struct size: 4x pointers + 4x size_t's */
 #define trie(type)                                   \
 	{                                            \
@@ -21,6 +29,7 @@ typedef void ( __cdecl * trie_xdealloc_t)(void *ptr);
 	}
 
 struct trie_node;
+struct trie_cursor;
 
 struct trieb {
 	struct trie_node *root;
@@ -49,8 +58,11 @@ void trie_cb_freecharptr(void *buf, void *userp);
 /* forward declarations */
 void *trie_setp(struct trieb *tr, const char *key);
 void *trie_getp(struct trieb *tr, const char *key);
+size_t trie_getp_many(struct trieb *tr, const char *const *keys, size_t n, void **out);
 int trie_cut(struct trieb *tr, const char *key);
 int trie_iter(struct trieb *tr, trie_itercb_t func, void *userp);
+struct trie_cursor *trie_cursor_new(struct trieb *tr);
+int trie_build_sorted(struct trieb *tr, const char *const *keys, const void *values, size_t n);
 void trie_destroynode(struct trieb *tr, struct trie_node *node);
 
 /**
@@ -65,6 +77,65 @@ void trie_use_as_malloc(trie_xalloc_t routine);
  */
 void trie_use_as_free(trie_xdealloc_t routine);
 
+/**
+ * trie_cursor_free() - release a cursor
+ * cur: cursor from trie_cursor_new(), or NULL
+ */
+void trie_cursor_free(struct trie_cursor *cur);
+
+/**
+ * trie_prefix_iter() - move a cursor to the first key with a given prefix
+ * cur: cursor from trie_cursor_new()
+ * prefix: pointer to a null terminated string
+ *
+ * Only the subtree of prefix is visited, trie_cursor_next() stops after its
+ * last key.
+ *
+ * Return: When there is such a key 1, or otherwise 0 (also if malloc() failed).
+ */
+int trie_prefix_iter(struct trie_cursor *cur, const char *prefix);
+
+/**
+ * trie_lower_bound() - move a cursor to the first key not less than a given key
+ * cur: cursor from trie_cursor_new()
+ * key: pointer to a null terminated string
+ *
+ * For a range [key, last) move on with trie_cursor_next() while the key of
+ * the cursor is less than last.
+ *
+ * Return: When there is such a key 1, or otherwise 0 (also if malloc() failed).
+ */
+int trie_lower_bound(struct trie_cursor *cur, const char *key);
+
+/**
+ * trie_cursor_next() - move a cursor to the next key, in strcmp() order
+ * cur: positioned cursor
+ *
+ * Return: When there is a next key 1, or otherwise 0 (also if malloc() failed).
+ */
+int trie_cursor_next(struct trie_cursor *cur);
+
+/**
+ * trie_cursor_key() - the key a cursor is at
+ * cur: cursor
+ *
+ * Return: The key, which is overwritten by the next move, or NULL if cur
+ *	is not at a key.
+ */
+const char *trie_cursor_key(const struct trie_cursor *cur);
+
+/**
+ * trie_cursor_value() - get a pointer to the value of the key a cursor is at
+ * cur: cursor
+ *
+ * Return: Pointer to the value, or NULL if cur is not at a key.
+ */
+void *trie_cursor_value(const struct trie_cursor *cur);
+
+#ifdef __cplusplus
+}
+#endif
+
 /**
  * trie_init() - initialize a trie
  * tr: typed pointer to the trie
@@ -178,6 +249,21 @@ void trie_use_as_free(trie_xdealloc_t routine);
 #define trie_getp(tr, key) \
 	(trie_getp)(&(tr)->s, (key))
 
+/**
+ * trie_getp_many() - get pointers to the values of a number of keys in a trie
+ * tr: typed pointer to the initialized trie
+ * keys: array of n pointers to null terminated strings
+ * n: number of keys
+ * out: array that receives n pointers, NULL where there is no such key
+ *
+ * The lookups are interleaved so that their cache misses overlap, which makes
+ * this faster than n calls of trie_getp().
+ *
+ * Return: The number of keys found.
+ */
+#define trie_getp_many(tr, keys, n, out) \
+	(trie_getp_many)(&(tr)->s, (keys), (n), (void **)(out))
+
 /**
  * trie_cut() - remove a given key from a trie
  * tr: typed pointer to the initialized trie
@@ -200,3 +286,36 @@ void trie_use_as_free(trie_xdealloc_t routine);
  */
 #define trie_iter(tr, func, userp) \
 	(trie_iter)(&(tr)->s, (func), (userp))
+
+/**
+ * trie_build_sorted() - replace the keys of a trie with a sorted array of keys
+ * tr: typed pointer to the initialized trie
+ * keys: array of n pointers to null terminated strings, in strictly increasing
+ *	strcmp() order
+ * values: array of the n values of the keys, or NULL to zero them
+ * n: number of keys
+ *
+ * The keys tr had are removed, once the new ones are in. The trie is built in
+ * one go, much faster than with n calls of trie_set(), and with the nodes of a
+ * subtree next to each other in memory.
+ *
+ * Return: When successful 1, or otherwise 0 if keys is not sorted or malloc()
+ *	failed, in which case tr is left unchanged.
+ */
+#define trie_build_sorted(tr, keys, values, n)                             \
+	((trie_build_sorted)(&(tr)->s, (keys), (values), (n)) ?            \
+	 ((tr)->size = (tr)->s.size, 1) : ((tr)->size = (tr)->s.size, 0))
+
+/**
+ * trie_cursor_new() - create a cursor on a trie
+ * tr: typed pointer to the initialized trie
+ *
+ * Positioning and moving a cursor does not allocate, unless a key is longer
+ * than any the trie had when the cursor was created. Setting, cutting or
+ * clearing keys invalidates the position, the cursor can be positioned again
+ * though. Unlike trie_iter(), this walks just a part of a trie.
+ *
+ * Return: The cursor, or NULL if malloc() failed.
+ */
+#define trie_cursor_new(tr) \
+	(trie_cursor_new)(&(tr)->s)
@@ -0,0 +1,1165 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#    include <emmintrin.h>
+#    define STATIC_DEQUE_SSE2
+#endif
+
+#pragma once
+
+// Hands out blocks (trie nodes) from chunks allocated through Allocator. Freed blocks go to a free list per size, reset ( )
+// makes all chunks available again in O(1) (without touching the blocks), release ( ) returns the chunks to the allocator.
+template<typename Allocator, std::size_t MaxBlock = 1'024u>
+class trie_arena {
+
+    struct chunk {
+        chunk * next;
+    };
+
+    struct free_block {
+        free_block * next;
+    };
+
+    public:
+    using allocator_type   = typename std::allocator_traits<Allocator>::template rebind_alloc<std::max_align_t>;
+    using allocator_traits = std::allocator_traits<allocator_type>;
+
+    static constexpr std::size_t granularity  = alignof ( std::max_align_t );
+    static constexpr std::size_t chunck_size  = 64u * 1'024u;
+    static constexpr std::size_t header_size  = ( sizeof ( chunk ) + granularity - 1 ) & ~( granularity - 1 );
+    static constexpr std::size_t size_classes = ( MaxBlock + granularity - 1 ) / granularity;
+    static constexpr std::size_t max_block    = size_classes * granularity;
+
+    static_assert ( header_size + max_block <= chunck_size, "Template parameter 2 is too large" );
+
+    explicit trie_arena ( Allocator const & a_ = Allocator ( ) ) noexcept : m_allocator ( a_ ) {}
+
+    trie_arena ( trie_arena && a_ ) noexcept :
+        m_allocator ( std::move ( a_.m_allocator ) ), m_chunks ( std::exchange ( a_.m_chunks, nullptr ) ),
+        m_current ( std::exchange ( a_.m_current, nullptr ) ), m_ptr ( std::exchange ( a_.m_ptr, nullptr ) ),
+        m_end ( std::exchange ( a_.m_end, nullptr ) ) {
+        std::copy ( std::begin ( a_.m_free ), std::end ( a_.m_free ), std::begin ( m_free ) );
+        std::fill ( std::begin ( a_.m_free ), std::end ( a_.m_free ), nullptr );
+    }
+
+    trie_arena ( trie_arena const & ) = delete;
+    trie_arena & operator= ( trie_arena const & ) = delete;
+
+    ~trie_arena ( ) noexcept { release ( ); }
+
+    [[nodiscard]] void * allocate ( std::size_t n_ ) {
+        assert ( n_ and n_ <= max_block );
+        std::size_t const c = ( n_ - 1 ) / granularity;
+        if ( free_block * b = m_free[ c ] ) {
+            m_free[ c ] = b->next;
+            return b;
+        }
+        n_ = ( c + 1 ) * granularity;
+        if ( static_cast<std::size_t> ( m_end - m_ptr ) < n_ )
+            next_chunk ( );
+        void * p = m_ptr;
+        m_ptr += n_;
+        return p;
+    }
+
+    void deallocate ( void * p_, std::size_t n_ ) noexcept {
+        std::size_t const c = ( n_ - 1 ) / granularity;
+        m_free[ c ]         = ::new ( p_ ) free_block{ m_free[ c ] };
+    }
+
+    // All blocks are freed, the chunks are kept.
+    void reset ( ) noexcept {
+        std::fill ( std::begin ( m_free ), std::end ( m_free ), nullptr );
+        m_current = m_chunks;
+        m_ptr     = m_current ? storage ( m_current ) : nullptr;
+        m_end     = m_current ? storage ( m_current ) + ( chunck_size - header_size ) : nullptr;
+    }
+
+    // All blocks are freed, the chunks are returned to the allocator.
+    void release ( ) noexcept {
+        for ( chunk * c = m_chunks; c; ) {
+            chunk * n = c->next;
+            allocator_traits::deallocate ( m_allocator, reinterpret_cast<std::max_align_t *> ( c ), chunck_size / granularity );
+            c = n;
+        }
+        m_chunks = nullptr;
+        reset ( );
+    }
+
+    [[nodiscard]] allocator_type const & get_allocator ( ) const noexcept { return m_allocator; }
+
+    private:
+    [[nodiscard]] static char * storage ( chunk * c_ ) noexcept { return reinterpret_cast<char *> ( c_ ) + header_size; }
+
+    // Moves on to the next kept chunk, or allocates one.
+    void next_chunk ( ) {
+        chunk * c = m_current ? m_current->next : m_chunks;
+        if ( not c ) {
+            c = ::new ( allocator_traits::allocate ( m_allocator, chunck_size / granularity ) ) chunk{ nullptr };
+            ( m_current ? m_current->next : m_chunks ) = c;
+        }
+        m_current = c;
+        m_ptr     = storage ( c );
+        m_end     = m_ptr + ( chunck_size - header_size );
+    }
+
+    allocator_type m_allocator;
+    chunk * m_chunks  = nullptr;
+    chunk * m_current = nullptr;
+    char * m_ptr      = nullptr;
+    char * m_end      = nullptr;
+    free_block * m_free[ size_classes ]{ };
+};
+
+// An adaptive radix tree (Leis, Kemper, Neumann, 2013) mapping strings to Type. Inner nodes come in four sizes (4, 16, 48 and
+// 256 children) and hold up to max_prefix bytes of the path (pessimistic path compression, longer runs become a chain of
+// nodes). Values live in leaves, which do not move for as long as their key is in the tree. A key that ends at an inner node
+// has its leaf hang off that node (its terminal), so keys can be prefixes of each other and can hold any byte.
+//
+// The nodes come from a per instance arena that allocates through Allocator (e.g. a std::pmr::polymorphic_allocator on a
+// monotonic_stack_resource). clear ( ) resets the arena, it is O(1) if Type is trivially destructible, otherwise the values
+// are destroyed in one walk that needs no stack. Keys are visited in lexicographic (unsigned byte) order.
+template<typename Type, typename Allocator = std::allocator<Type>>
+class radix_trie {
+
+    static_assert ( alignof ( Type ) <= alignof ( std::max_align_t ), "Template parameter 1 cannot be over aligned" );
+
+    public:
+    using key_type        = std::string_view;
+    using value_type      = Type;
+    using pointer         = value_type *;
+    using const_pointer   = value_type const *;
+    using reference       = value_type &;
+    using const_reference = value_type const &;
+    using size_type       = std::size_t;
+    using allocator_type  = Allocator;
+
+    static constexpr std::size_t max_prefix = 12u;
+
+    private:
+    template<typename T>
+    using rebind = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+    enum class kind : std::uint8_t { leaf, node4, node16, node48, node256 };
+
+    struct header {
+        kind type;
+        std::uint8_t prefix_len = 0u;
+        std::uint16_t count     = 0u; // Of the children.
+        unsigned char prefix[ max_prefix ];
+
+        explicit header ( kind k_ ) noexcept : type ( k_ ) {}
+
+        void set_prefix ( unsigned char const * p_, std::size_t n_ ) noexcept {
+            assert ( n_ <= max_prefix );
+            if ( n_ )
+                std::memcpy ( prefix, p_, n_ );
+            prefix_len = static_cast<std::uint8_t> ( n_ );
+        }
+        void set_prefix ( key_type k_ ) noexcept {
+            set_prefix ( reinterpret_cast<unsigned char const *> ( k_.data ( ) ), k_.size ( ) );
+        }
+    };
+
+    struct leaf : header {
+        alignas ( value_type ) unsigned char storage[ sizeof ( value_type ) ];
+
+        leaf ( ) noexcept : header ( kind::leaf ) {}
+
+        [[nodiscard]] pointer value ( ) noexcept { return std::launder ( reinterpret_cast<pointer> ( storage ) ); }
+        [[nodiscard]] const_pointer value ( ) const noexcept {
+            return std::launder ( reinterpret_cast<const_pointer> ( storage ) );
+        }
+    };
+
+    struct inner : header {
+        header * terminal = nullptr; // The leaf of the key that ends here, while draining the link to the next node.
+
+        using header::header;
+    };
+
+    struct node4 : inner {
+        unsigned char keys[ 4 ];
+        header * children[ 4 ];
+
+        node4 ( ) noexcept : inner ( kind::node4 ) {}
+    };
+
+    struct node16 : inner {
+        alignas ( 16 ) unsigned char keys[ 16 ];
+        header * children[ 16 ];
+
+        node16 ( ) noexcept : inner ( kind::node16 ) {}
+    };
+
+    struct node48 : inner {
+        std::uint8_t index[ 256 ]; // One plus the slot of the child, 0 if there is none.
+        header * children[ 48 ];
+
+        node48 ( ) noexcept : inner ( kind::node48 ) {
+            std::fill ( std::begin ( index ), std::end ( index ), std::uint8_t{ 0u } );
+            std::fill ( std::begin ( children ), std::end ( children ), nullptr );
+        }
+    };
+
+    struct node256 : inner {
+        header * children[ 256 ];
+
+        node256 ( ) noexcept : inner ( kind::node256 ) { std::fill ( std::begin ( children ), std::end ( children ), nullptr ); }
+    };
+
+    static constexpr std::size_t max_node_size = std::max ( sizeof ( node256 ), sizeof ( leaf ) );
+
+    public:
+    explicit radix_trie ( allocator_type const & a_ = allocator_type ( ) ) noexcept : m_arena ( a_ ) {}
+
+    radix_trie ( radix_trie && t_ ) noexcept :
+        m_arena ( std::move ( t_.m_arena ) ), m_root ( std::exchange ( t_.m_root, nullptr ) ),
+        m_size ( std::exchange ( t_.m_size, 0u ) ) {}
+
+    radix_trie ( radix_trie const & ) = delete;
+    radix_trie & operator= ( radix_trie const & ) = delete;
+
+    ~radix_trie ( ) noexcept { destroy_values ( ); }
+
+    // Sizes.
+
+    [[nodiscard]] size_type size ( ) const noexcept { return m_size; }
+    [[nodiscard]] bool empty ( ) const noexcept { return not m_size; }
+
+    // Lookup.
+
+    [[nodiscard]] pointer find ( key_type k_ ) noexcept { return const_cast<pointer> ( std::as_const ( *this ).find ( k_ ) ); }
+    [[nodiscard]] const_pointer find ( key_type k_ ) const noexcept {
+        header const * n = m_root;
+        std::size_t i    = 0u;
+        const_pointer r  = nullptr;
+        for ( ;; )
+            if ( step ( n, k_, i, r ) )
+                return r;
+    }
+
+    // Looks up n_ keys, out_[ i ] becomes what find ( keys_[ i ] ) returns. Group lookups are kept in flight, each one
+    // takes a step down the tree in turn and prefetches the node it moves to, so that the cache misses of the lookups
+    // overlap instead of following each other. A lookup that finishes hands its place to the next key.
+    template<std::size_t Group = 16u>
+    void find_many ( key_type const * keys_, std::size_t n_, const_pointer * out_ ) const noexcept {
+        struct lookup {
+            header const * node;
+            std::size_t i; // Into the key.
+            std::size_t key;
+        };
+        lookup g[ Group ];
+        std::size_t active = 0u, next = 0u;
+        for ( ; active < Group and next < n_; ++active, ++next )
+            g[ active ] = { m_root, 0u, next };
+        prefetch ( m_root );
+        while ( active ) {
+            for ( std::size_t j = 0u; j < active; ) {
+                lookup & l = g[ j ];
+                if ( not step ( l.node, keys_[ l.key ], l.i, out_[ l.key ] ) ) {
+                    prefetch ( l.node );
+                    ++j;
+                }
+                else if ( next < n_ ) {
+                    l = { m_root, 0u, next++ };
+                    ++j;
+                }
+                else {
+                    l = g[ --active ];
+                }
+            }
+        }
+    }
+    template<std::size_t Group = 16u>
+    void find_many ( key_type const * keys_, std::size_t n_, pointer * out_ ) noexcept {
+        std::as_const ( *this ).template find_many<Group> ( keys_, n_, const_cast<const_pointer *> ( out_ ) );
+    }
+
+    [[nodiscard]] bool contains ( key_type k_ ) const noexcept { return find ( k_ ); }
+
+    // Modifiers.
+
+    // Returns the value of k_ and whether it was inserted, constructed from args_ if it was.
+    template<typename... Args>
+    std::pair<pointer, bool> try_emplace ( key_type k_, Args &&... args_ ) {
+        header ** ref = &m_root;
+        std::size_t i = 0u;
+        for ( ;; ) {
+            header * n = *ref;
+            if ( not n ) {
+                tail t ( *this, k_.substr ( i ), std::forward<Args> ( args_ )... );
+                *ref = t.release ( );
+                return inserted ( t.value );
+            }
+            std::size_t const p = common_prefix ( n, k_.substr ( i ) );
+            if ( p < n->prefix_len ) {
+                // Split n, a node4 takes the common part and n keeps what follows its branch byte.
+                tail t ( *this, p == k_.size ( ) - i ? key_type ( ) : k_.substr ( i + p + 1u ), std::forward<Args> ( args_ )... );
+                node4 * s = make<node4> ( );
+                s->set_prefix ( n->prefix, p );
+                unsigned char const b = n->prefix[ p ];
+                std::memmove ( n->prefix, n->prefix + p + 1u, n->prefix_len - p - 1u );
+                n->prefix_len = static_cast<std::uint8_t> ( n->prefix_len - p - 1u );
+                insert_sorted ( s, b, n );
+                if ( p == k_.size ( ) - i )
+                    s->terminal = t.release ( );
+                else
+                    insert_sorted ( s, static_cast<unsigned char> ( k_[ i + p ] ), t.release ( ) );
+                *ref = s;
+                return inserted ( t.value );
+            }
+            i += p;
+            if ( n->type == kind::leaf ) {
+                if ( i == k_.size ( ) )
+                    return { static_cast<leaf *> ( n )->value ( ), false };
+                // The key goes on, the leaf becomes the terminal of a node4 that takes its prefix.
+                tail t ( *this, k_.substr ( i + 1u ), std::forward<Args> ( args_ )... );
+                node4 * s = make<node4> ( );
+                s->set_prefix ( n->prefix, n->prefix_len );
+                n->prefix_len = 0u;
+                s->terminal   = n;
+                insert_sorted ( s, static_cast<unsigned char> ( k_[ i ] ), t.release ( ) );
+                *ref = s;
+                return inserted ( t.value );
+            }
+            inner * in = static_cast<inner *> ( n );
+            if ( i == k_.size ( ) ) {
+                if ( in->terminal )
+                    return { static_cast<leaf *> ( in->terminal )->value ( ), false };
+                tail t ( *this, key_type ( ), std::forward<Args> ( args_ )... );
+                in->terminal = t.release ( );
+                return inserted ( t.value );
+            }
+            unsigned char const b = static_cast<unsigned char> ( k_[ i++ ] );
+            if ( header ** c = find_child ( in, b ) ) {
+                ref = c;
+                continue;
+            }
+            tail t ( *this, k_.substr ( i ), std::forward<Args> ( args_ )... );
+            add_child ( ref, in, b, t.top );
+            t.top = nullptr;
+            return inserted ( t.value );
+        }
+    }
+
+    [[nodiscard]] reference operator[] ( key_type k_ ) { return *try_emplace ( k_ ).first; }
+
+    // Removes k_, together with the chain of nodes that only led to it.
+    [[maybe_unused]] bool erase ( key_type k_ ) noexcept {
+        header ** ref        = &m_root;
+        header ** cut        = ref;     // The link to the top of the chain that goes with k_,
+        header ** cut_parent = nullptr; // the link to its parent
+        unsigned char cut_byte = 0u;    // and the byte of the chain in that parent.
+        std::size_t i          = 0u;
+        for ( ;; ) {
+            header * n = *ref;
+            if ( not n or n->prefix_len > k_.size ( ) - i or differs ( n, k_.data ( ) + i, n->prefix_len ) )
+                return false;
+            i += n->prefix_len;
+            if ( n->type == kind::leaf ) {
+                if ( i != k_.size ( ) )
+                    return false;
+                break;
+            }
+            inner * in = static_cast<inner *> ( n );
+            if ( i == k_.size ( ) ) {
+                if ( not in->terminal )
+                    return false;
+                free_leaf ( static_cast<leaf *> ( in->terminal ) );
+                in->terminal = nullptr;
+                --m_size;
+                compact ( ref );
+                return true;
+            }
+            unsigned char const b = static_cast<unsigned char> ( k_[ i++ ] );
+            header ** c           = find_child ( in, b );
+            if ( not c )
+                return false;
+            if ( in->count > 1u or in->terminal ) {
+                cut        = c;
+                cut_parent = ref;
+                cut_byte   = b;
+            }
+            ref = c;
+        }
+        // Every node from *cut down to the leaf has one child and no terminal.
+        for ( header * n = *cut; n; ) {
+            if ( n->type == kind::leaf ) {
+                free_leaf ( static_cast<leaf *> ( n ) );
+                break;
+            }
+            header * c = only_child ( static_cast<inner *> ( n ) );
+            free_node ( n );
+            n = c;
+        }
+        --m_size;
+        if ( cut_parent ) {
+            remove_child ( cut_parent, static_cast<inner *> ( *cut_parent ), cut_byte );
+            compact ( cut_parent );
+        }
+        else {
+            *cut = nullptr;
+        }
+        return true;
+    }
+
+    // Replaces the contents with the n_ keys keys_, which must be strictly increasing, key i getting the value value_ ( i ).
+    // One pass over the keys finds the prefix each key shares with the one before it, the nodes then follow from scans
+    // of those lengths, without a walk from the root per key. Every node is made once, with the children it ends up with,
+    // and in depth first order, so that a subtree is contiguous in memory. All memory, also for the scratch space (4 bytes
+    // per key), comes from Allocator.
+    template<typename Function>
+    void build_sorted ( key_type const * keys_, std::size_t n_, Function value_ ) {
+        std::vector<std::uint32_t, rebind<std::uint32_t>> shared ( n_, m_arena.get_allocator ( ) ); // By key i and key i - 1.
+        for ( std::size_t i = 1u; i < n_; ++i ) {
+            key_type const a = keys_[ i - 1u ], b = keys_[ i ];
+            std::size_t const m = std::min ( a.size ( ), b.size ( ) );
+            std::size_t j       = 0u;
+            while ( j < m and a[ j ] == b[ j ] )
+                ++j;
+            if ( j == b.size ( ) or ( j < a.size ( ) and key_type::traits_type::lt ( b[ j ], a[ j ] ) ) )
+                throw std::invalid_argument ( "the keys are not strictly increasing" );
+            if ( j > std::numeric_limits<std::uint32_t>::max ( ) )
+                throw std::length_error ( "the keys are too long" );
+            shared[ i ] = static_cast<std::uint32_t> ( j );
+        }
+        clear ( );
+        struct range {
+            std::size_t lo, hi, depth; // The keys lo up to hi share their first depth bytes,
+            header ** slot;            // and go here.
+        };
+        std::vector<range, rebind<range>> todo ( m_arena.get_allocator ( ) );
+        if ( n_ )
+            todo.push_back ( { 0u, n_, 0u, &m_root } );
+        try {
+            while ( not todo.empty ( ) ) {
+                auto [ lo, hi, d, slot ] = todo.back ( );
+                todo.pop_back ( );
+                key_type const first = keys_[ lo ];
+                std::size_t l        = first.size ( );
+                if ( hi - lo > 1u )
+                    l = *std::min_element ( shared.begin ( ) + lo + 1u, shared.begin ( ) + hi );
+                while ( l - d > max_prefix ) {
+                    node4 * c = make<node4> ( );
+                    c->set_prefix ( first.substr ( d, max_prefix ) );
+                    c->keys[ 0 ]     = static_cast<unsigned char> ( first[ d + max_prefix ] );
+                    c->children[ 0 ] = nullptr;
+                    c->count         = 1u;
+                    *slot            = c;
+                    slot             = c->children;
+                    d += max_prefix + 1u;
+                }
+                if ( hi - lo == 1u ) {
+                    leaf * f = make_leaf ( value_ ( lo ) );
+                    f->set_prefix ( first.substr ( d ) );
+                    *slot = f;
+                    ++m_size;
+                    continue;
+                }
+                // The children, by the byte that follows the shared prefix, start where a key shares just that with the
+                // one before it.
+                std::size_t const from = lo + ( first.size ( ) == l );
+                std::size_t starts[ 257 ];
+                std::size_t count = 0u;
+                starts[ count++ ] = from;
+                for ( std::size_t i = from + 1u; i < hi; ++i )
+                    if ( shared[ i ] == l )
+                        starts[ count++ ] = i;
+                starts[ count ] = hi;
+                inner * in      = count <= 4u    ? static_cast<inner *> ( make<node4> ( ) )
+                                  : count <= 16u ? static_cast<inner *> ( make<node16> ( ) )
+                                  : count <= 48u ? static_cast<inner *> ( make<node48> ( ) )
+                                                 : static_cast<inner *> ( make<node256> ( ) );
+                in->set_prefix ( first.substr ( d, l - d ) );
+                *slot = in;
+                if ( from != lo ) {
+                    in->terminal = make_leaf ( value_ ( lo ) );
+                    ++m_size;
+                }
+                for ( std::size_t g = count; g--; ) {
+                    unsigned char const b = static_cast<unsigned char> ( keys_[ starts[ g ] ][ l ] );
+                    todo.push_back ( { starts[ g ], starts[ g + 1u ], l + 1u, child_slot ( in, b, g ) } );
+                }
+                in->count = static_cast<std::uint16_t> ( count );
+            }
+        }
+        catch ( ... ) {
+            // The nodes are complete up to the first child that is not there yet.
+            clear ( );
+            throw;
+        }
+    }
+
+    // Removes all keys, the memory is kept for reuse.
+    void clear ( ) noexcept {
+        destroy_values ( );
+        m_arena.reset ( );
+        m_root = nullptr;
+        m_size = 0u;
+    }
+
+    // Removes all keys and returns the memory to the allocator.
+    void release ( ) noexcept {
+        clear ( );
+        m_arena.release ( );
+    }
+
+    // Calls f_ ( value ) for every value, in no particular order, and clears the trie. Nothing is allocated.
+    template<typename Function>
+    void consume ( Function f_ ) {
+        drain ( [ &f_ ] ( leaf * l_ ) {
+            f_ ( *l_->value ( ) );
+            l_->value ( )->~value_type ( );
+        } );
+        m_arena.reset ( );
+        m_root = nullptr;
+        m_size = 0u;
+    }
+
+    // Iterators.
+
+    class cursor;
+
+    // Calls f_ ( key, value ) for every key, in lexicographic order.
+    template<typename Function>
+    void for_each ( Function f_ ) {
+        cursor c ( *this );
+        for ( bool v = c.seek ( key_type ( ) ); v; v = c.next ( ) )
+            f_ ( c.key ( ), c.value ( ) );
+    }
+
+    // Walks the keys in lexicographic order, from where seek ( ) or seek_prefix ( ) put it. The key buffer and the path
+    // are allocated (through Allocator) up front, and only grow if a key does not fit, so a scan does not allocate. Any
+    // insertion or removal invalidates the cursor, it has to seek again.
+    class cursor {
+
+        struct frame {
+            inner * node;
+            unsigned next; // The first byte not visited yet.
+            std::size_t size;
+        };
+
+        public:
+        explicit cursor ( radix_trie & t_, std::size_t reserve_ = 64u ) :
+            m_trie ( &t_ ), m_key ( rebind<char> ( t_.get_allocator ( ) ) ), m_path ( rebind<frame> ( t_.get_allocator ( ) ) ) {
+            m_key.reserve ( reserve_ );
+            m_path.reserve ( reserve_ + 1u );
+        }
+
+        // To the first key not less than k_.
+        bool seek ( key_type k_ ) {
+            reset ( );
+            header * n    = m_trie->m_root;
+            std::size_t i = 0u;
+            while ( n ) {
+                std::size_t const m = std::min<std::size_t> ( n->prefix_len, k_.size ( ) - i );
+                std::size_t p       = 0u;
+                while ( p < m and n->prefix[ p ] == static_cast<unsigned char> ( k_[ i + p ] ) )
+                    ++p;
+                if ( p < m ) // All keys below n are either greater or less than k_.
+                    return n->prefix[ p ] > static_cast<unsigned char> ( k_[ i + p ] ) ? enter ( n ) or next ( ) : next ( );
+                if ( m < n->prefix_len ) // k_ is a prefix of the keys below n.
+                    return enter ( n ) or next ( );
+                m_key.append ( reinterpret_cast<char const *> ( n->prefix ), n->prefix_len );
+                i += n->prefix_len;
+                if ( n->type == kind::leaf ) {
+                    if ( i == k_.size ( ) ) {
+                        m_leaf = static_cast<leaf *> ( n );
+                        return true;
+                    }
+                    return next ( );
+                }
+                inner * in = static_cast<inner *> ( n );
+                m_path.push_back ( { in, 0u, m_key.size ( ) } );
+                if ( i == k_.size ( ) ) {
+                    if ( in->terminal ) {
+                        m_leaf = static_cast<leaf *> ( in->terminal );
+                        return true;
+                    }
+                    return next ( );
+                }
+                unsigned char const b = static_cast<unsigned char> ( k_[ i++ ] );
+                m_path.back ( ).next  = b;
+                header ** c           = find_child ( in, b );
+                if ( not c )
+                    return next ( );
+                m_path.back ( ).next = b + 1u;
+                m_key.push_back ( static_cast<char> ( b ) );
+                n = *c;
+            }
+            return false;
+        }
+
+        // To the first key that starts with p_, next ( ) stops after the last one.
+        bool seek_prefix ( key_type p_ ) {
+            reset ( );
+            header * n    = m_trie->m_root;
+            std::size_t i = 0u;
+            while ( n ) {
+                std::size_t const r = p_.size ( ) - i;
+                if ( differs ( n, p_.data ( ) + i, std::min<std::size_t> ( n->prefix_len, r ) ) )
+                    return false;
+                if ( r <= n->prefix_len ) {
+                    m_key.assign ( p_.data ( ), i );
+                    return enter ( n ) or next ( );
+                }
+                i += n->prefix_len;
+                if ( n->type == kind::leaf )
+                    return false;
+                header ** c = find_child ( static_cast<inner *> ( n ), static_cast<unsigned char> ( p_[ i++ ] ) );
+                n           = c ? *c : nullptr;
+            }
+            return false;
+        }
+
+        // To the next key, returns false at the end.
+        bool next ( ) {
+            while ( not m_path.empty ( ) ) {
+                frame & f       = m_path.back ( );
+                unsigned char b = 0u;
+                header * c      = next_child ( f.node, f.next, b );
+                if ( not c ) {
+                    m_path.pop_back ( );
+                    continue;
+                }
+                f.next = b + 1u;
+                m_key.resize ( f.size );
+                m_key.push_back ( static_cast<char> ( b ) );
+                if ( enter ( c ) )
+                    return true;
+            }
+            m_leaf = nullptr;
+            return false;
+        }
+
+        [[nodiscard]] bool valid ( ) const noexcept { return m_leaf; }
+        [[nodiscard]] explicit operator bool ( ) const noexcept { return m_leaf; }
+
+        // The key is 0 terminated, its buffer is reused by the next move.
+        [[nodiscard]] key_type key ( ) const noexcept { return m_key; }
+        [[nodiscard]] char const * c_str ( ) const noexcept { return m_key.c_str ( ); }
+        [[nodiscard]] reference value ( ) const noexcept { return *m_leaf->value ( ); }
+
+        private:
+        void reset ( ) noexcept {
+            m_key.clear ( );
+            m_path.clear ( );
+            m_leaf = nullptr;
+        }
+
+        // Returns true if the key that ends at n_ is the next one, otherwise n_ goes on the path.
+        bool enter ( header * n_ ) {
+            m_key.append ( reinterpret_cast<char const *> ( n_->prefix ), n_->prefix_len );
+            if ( n_->type == kind::leaf ) {
+                m_leaf = static_cast<leaf *> ( n_ );
+                return true;
+            }
+            inner * in = static_cast<inner *> ( n_ );
+            m_path.push_back ( { in, 0u, m_key.size ( ) } );
+            m_leaf = static_cast<leaf *> ( in->terminal );
+            return m_leaf;
+        }
+
+        radix_trie * m_trie;
+        std::basic_string<char, std::char_traits<char>, rebind<char>> m_key;
+        std::vector<frame, rebind<frame>> m_path;
+        leaf * m_leaf = nullptr;
+    };
+
+    [[nodiscard]] allocator_type get_allocator ( ) const noexcept { return allocator_type ( m_arena.get_allocator ( ) ); }
+
+    private:
+    // The chain of nodes for the rest of a key, and its leaf. Frees what it holds unless released, so that an exception
+    // leaves the trie as it was.
+    struct tail {
+        radix_trie & trie;
+        header * top = nullptr;
+        pointer value;
+
+        template<typename... Args>
+        tail ( radix_trie & t_, key_type r_, Args &&... args_ ) : trie ( t_ ) {
+            leaf * l = t_.make_leaf ( std::forward<Args> ( args_ )... );
+            value    = l->value ( );
+            header ** link = &top;
+            *link          = l;
+            try {
+                while ( r_.size ( ) > max_prefix ) {
+                    node4 * n = t_.template make<node4> ( );
+                    n->set_prefix ( r_.substr ( 0u, max_prefix ) );
+                    n->keys[ 0 ]     = static_cast<unsigned char> ( r_[ max_prefix ] );
+                    n->children[ 0 ] = l;
+                    n->count         = 1u;
+                    *link            = n;
+                    link             = &n->children[ 0 ];
+                    r_.remove_prefix ( max_prefix + 1u );
+                }
+            }
+            catch ( ... ) {
+                dispose ( );
+                throw;
+            }
+            l->set_prefix ( r_ );
+        }
+
+        tail ( tail const & ) = delete;
+        tail & operator= ( tail const & ) = delete;
+
+        ~tail ( ) noexcept { dispose ( ); }
+
+        [[nodiscard]] header * release ( ) noexcept { return std::exchange ( top, nullptr ); }
+
+        void dispose ( ) noexcept {
+            while ( top and top->type != kind::leaf ) {
+                header * c = static_cast<node4 *> ( top )->children[ 0 ];
+                trie.free_node ( top );
+                top = c;
+            }
+            if ( top )
+                trie.free_leaf ( static_cast<leaf *> ( std::exchange ( top, nullptr ) ) );
+        }
+    };
+
+    // One step of a lookup of k_, of which n_ has matched i_ bytes: returns false having moved n_ to the next node, or true
+    // with the value of k_ (or nullptr) in r_.
+    [[nodiscard]] static bool step ( header const *& n_, key_type k_, std::size_t & i_, const_pointer & r_ ) noexcept {
+        header const * n = n_;
+        r_               = nullptr;
+        if ( not n or n->prefix_len > k_.size ( ) - i_ or differs ( n, k_.data ( ) + i_, n->prefix_len ) )
+            return true;
+        i_ += n->prefix_len;
+        if ( n->type == kind::leaf ) {
+            if ( i_ == k_.size ( ) )
+                r_ = static_cast<leaf const *> ( n )->value ( );
+            return true;
+        }
+        inner const * in = static_cast<inner const *> ( n );
+        if ( i_ == k_.size ( ) ) {
+            if ( in->terminal )
+                r_ = static_cast<leaf const *> ( in->terminal )->value ( );
+            return true;
+        }
+        header * const * c = find_child ( in, static_cast<unsigned char> ( k_[ i_++ ] ) );
+        n_                 = c ? *c : nullptr;
+        return not n_;
+    }
+
+    static void prefetch ( void const * p_ ) noexcept {
+#if defined( __GNUC__ ) || defined( __clang__ )
+        __builtin_prefetch ( p_ );
+#elif defined( STATIC_DEQUE_SSE2 )
+        _mm_prefetch ( static_cast<char const *> ( p_ ), _MM_HINT_T0 );
+#else
+        static_cast<void> ( p_ );
+#endif
+    }
+
+    [[nodiscard]] std::pair<pointer, bool> inserted ( pointer p_ ) noexcept {
+        ++m_size;
+        return { p_, true };
+    }
+
+    // Whether the first n_ bytes of the prefix of h_ differ from k_ (which may be null if n_ is 0).
+    [[nodiscard]] static bool differs ( header const * h_, char const * k_, std::size_t n_ ) noexcept {
+        return n_ and std::memcmp ( h_->prefix, k_, n_ );
+    }
+
+    [[nodiscard]] static std::size_t common_prefix ( header const * n_, key_type k_ ) noexcept {
+        std::size_t const m = std::min<std::size_t> ( n_->prefix_len, k_.size ( ) );
+        std::size_t p       = 0u;
+        while ( p < m and n_->prefix[ p ] == static_cast<unsigned char> ( k_[ p ] ) )
+            ++p;
+        return p;
+    }
+
+    // Allocation.
+
+    template<typename Node>
+    [[nodiscard]] Node * make ( ) {
+        return ::new ( m_arena.allocate ( sizeof ( Node ) ) ) Node ( );
+    }
+
+    template<typename... Args>
+    [[nodiscard]] leaf * make_leaf ( Args &&... args_ ) {
+        void * p = m_arena.allocate ( sizeof ( leaf ) );
+        leaf * l = ::new ( p ) leaf ( );
+        try {
+            ::new ( l->storage ) value_type ( std::forward<Args> ( args_ )... );
+        }
+        catch ( ... ) {
+            m_arena.deallocate ( p, sizeof ( leaf ) );
+            throw;
+        }
+        return l;
+    }
+
+    void free_leaf ( leaf * l_ ) noexcept {
+        l_->value ( )->~value_type ( );
+        m_arena.deallocate ( l_, sizeof ( leaf ) );
+    }
+
+    [[nodiscard]] static std::size_t node_size ( kind k_ ) noexcept {
+        switch ( k_ ) {
+            case kind::node4: return sizeof ( node4 );
+            case kind::node16: return sizeof ( node16 );
+            case kind::node48: return sizeof ( node48 );
+            case kind::node256: return sizeof ( node256 );
+            default: return sizeof ( leaf );
+        }
+    }
+
+    void free_node ( header * n_ ) noexcept { m_arena.deallocate ( n_, node_size ( n_->type ) ); }
+
+    // Children.
+
+    [[nodiscard]] static header * const * find_child ( inner const * n_, unsigned char b_ ) noexcept {
+        switch ( n_->type ) {
+            case kind::node4: {
+                node4 const * n = static_cast<node4 const *> ( n_ );
+                for ( std::size_t i = 0u; i < n->count; ++i )
+                    if ( n->keys[ i ] == b_ )
+                        return n->children + i;
+                return nullptr;
+            }
+            case kind::node16: {
+                node16 const * n = static_cast<node16 const *> ( n_ );
+#if defined( STATIC_DEQUE_SSE2 )
+                __m128i const k  = _mm_load_si128 ( reinterpret_cast<__m128i const *> ( n->keys ) );
+                __m128i const e  = _mm_cmpeq_epi8 ( _mm_set1_epi8 ( static_cast<char> ( b_ ) ), k );
+                unsigned const m = static_cast<unsigned> ( _mm_movemask_epi8 ( e ) ) & ( ( 1u << n->count ) - 1u );
+                return m ? n->children + std::countr_zero ( m ) : nullptr;
+#else
+                for ( std::size_t i = 0u; i < n->count; ++i )
+                    if ( n->keys[ i ] == b_ )
+                        return n->children + i;
+                return nullptr;
+#endif
+            }
+            case kind::node48: {
+                node48 const * n = static_cast<node48 const *> ( n_ );
+                return n->index[ b_ ] ? n->children + ( n->index[ b_ ] - 1u ) : nullptr;
+            }
+            case kind::node256: {
+                node256 const * n = static_cast<node256 const *> ( n_ );
+                return n->children[ b_ ] ? n->children + b_ : nullptr;
+            }
+            default: return nullptr;
+        }
+    }
+    [[nodiscard]] static header ** find_child ( inner * n_, unsigned char b_ ) noexcept {
+        return const_cast<header **> ( find_child ( static_cast<inner const *> ( n_ ), b_ ) );
+    }
+
+    // The child with the lowest byte not less than from_, its byte goes to b_.
+    [[nodiscard]] static header * next_child ( inner const * n_, unsigned from_, unsigned char & b_ ) noexcept {
+        switch ( n_->type ) {
+            case kind::node4:
+            case kind::node16: {
+                unsigned char const * keys = n_->type == kind::node4 ? static_cast<node4 const *> ( n_ )->keys
+                                                                     : static_cast<node16 const *> ( n_ )->keys;
+                header * const * children  = n_->type == kind::node4 ? static_cast<node4 const *> ( n_ )->children
+                                                                     : static_cast<node16 const *> ( n_ )->children;
+                for ( std::size_t i = 0u; i < n_->count; ++i )
+                    if ( keys[ i ] >= from_ ) {
+                        b_ = keys[ i ];
+                        return children[ i ];
+                    }
+                return nullptr;
+            }
+            case kind::node48: {
+                node48 const * n = static_cast<node48 const *> ( n_ );
+                for ( unsigned b = from_; b < 256u; ++b )
+                    if ( n->index[ b ] ) {
+                        b_ = static_cast<unsigned char> ( b );
+                        return n->children[ n->index[ b ] - 1u ];
+                    }
+                return nullptr;
+            }
+            case kind::node256: {
+                node256 const * n = static_cast<node256 const *> ( n_ );
+                for ( unsigned b = from_; b < 256u; ++b )
+                    if ( n->children[ b ] ) {
+                        b_ = static_cast<unsigned char> ( b );
+                        return n->children[ b ];
+                    }
+                return nullptr;
+            }
+            default: return nullptr;
+        }
+    }
+
+    [[nodiscard]] static header * only_child ( inner const * n_ ) noexcept {
+        unsigned char b = 0u;
+        return next_child ( n_, 0u, b );
+    }
+
+    template<typename Small>
+    static void insert_sorted ( Small * n_, unsigned char b_, header * c_ ) noexcept {
+        std::size_t i = n_->count;
+        for ( ; i and n_->keys[ i - 1u ] > b_; --i ) {
+            n_->keys[ i ]     = n_->keys[ i - 1u ];
+            n_->children[ i ] = n_->children[ i - 1u ];
+        }
+        n_->keys[ i ]     = b_;
+        n_->children[ i ] = c_;
+        ++n_->count;
+    }
+
+    // Adds an empty child under b_ to n_, as its child number g_, before count is set.
+    [[nodiscard]] static header ** child_slot ( inner * n_, unsigned char b_, std::size_t g_ ) noexcept {
+        switch ( n_->type ) {
+            case kind::node4: {
+                node4 * n     = static_cast<node4 *> ( n_ );
+                n->keys[ g_ ] = b_;
+                return &( n->children[ g_ ] = nullptr );
+            }
+            case kind::node16: {
+                node16 * n    = static_cast<node16 *> ( n_ );
+                n->keys[ g_ ] = b_;
+                return &( n->children[ g_ ] = nullptr );
+            }
+            case kind::node48: {
+                node48 * n     = static_cast<node48 *> ( n_ );
+                n->index[ b_ ] = static_cast<std::uint8_t> ( g_ + 1u );
+                return n->children + g_;
+            }
+            default: return static_cast<node256 *> ( n_ )->children + b_;
+        }
+    }
+
+    template<typename To>
+    [[nodiscard]] To * copy_header ( inner const * n_ ) {
+        To * t = make<To> ( );
+        t->set_prefix ( n_->prefix, n_->prefix_len );
+        t->terminal = n_->terminal;
+        return t;
+    }
+
+    // Adds c_ under b_ to *ref_ (which is n_), growing n_ into the next size if it is full.
+    void add_child ( header ** ref_, inner * n_, unsigned char b_, header * c_ ) {
+        switch ( n_->type ) {
+            case kind::node4: {
+                node4 * n = static_cast<node4 *> ( n_ );
+                if ( n->count < 4u )
+                    return insert_sorted ( n, b_, c_ );
+                node16 * g = copy_header<node16> ( n );
+                for ( std::size_t i = 0u; i < 4u; ++i )
+                    insert_sorted ( g, n->keys[ i ], n->children[ i ] );
+                insert_sorted ( g, b_, c_ );
+                *ref_ = g;
+                break;
+            }
+            case kind::node16: {
+                node16 * n = static_cast<node16 *> ( n_ );
+                if ( n->count < 16u )
+                    return insert_sorted ( n, b_, c_ );
+                node48 * g = copy_header<node48> ( n );
+                for ( std::size_t i = 0u; i < 16u; ++i ) {
+                    g->index[ n->keys[ i ] ] = static_cast<std::uint8_t> ( i + 1u );
+                    g->children[ i ]         = n->children[ i ];
+                }
+                g->children[ 16 ] = c_;
+                g->index[ b_ ]    = 17u;
+                g->count          = 17u;
+                *ref_             = g;
+                break;
+            }
+            case kind::node48: {
+                node48 * n = static_cast<node48 *> ( n_ );
+                if ( n->count < 48u ) {
+                    std::size_t s = 0u;
+                    while ( n->children[ s ] )
+                        ++s;
+                    n->children[ s ] = c_;
+                    n->index[ b_ ]   = static_cast<std::uint8_t> ( s + 1u );
+                    ++n->count;
+                    return;
+                }
+                node256 * g = copy_header<node256> ( n );
+                for ( unsigned b = 0u; b < 256u; ++b )
+                    if ( n->index[ b ] )
+                        g->children[ b ] = n->children[ n->index[ b ] - 1u ];
+                g->children[ b_ ] = c_;
+                g->count          = 49u;
+                *ref_             = g;
+                break;
+            }
+            case kind::node256: {
+                node256 * n       = static_cast<node256 *> ( n_ );
+                n->children[ b_ ] = c_;
+                ++n->count;
+                return;
+            }
+            default: assert ( false );
+        }
+        free_node ( n_ );
+    }
+
+    // Removes the child under b_ from *ref_ (which is n_), shrinking n_ into the next size down if it got sparse.
+    void remove_child ( header ** ref_, inner * n_, unsigned char b_ ) noexcept {
+        switch ( n_->type ) {
+            case kind::node4:
+            case kind::node16: {
+                unsigned char * keys =
+                    n_->type == kind::node4 ? static_cast<node4 *> ( n_ )->keys : static_cast<node16 *> ( n_ )->keys;
+                header ** children =
+                    n_->type == kind::node4 ? static_cast<node4 *> ( n_ )->children : static_cast<node16 *> ( n_ )->children;
+                std::size_t i = 0u;
+                while ( keys[ i ] != b_ )
+                    ++i;
+                std::memmove ( keys + i, keys + i + 1u, n_->count - i - 1u );
+                std::memmove ( children + i, children + i + 1u, ( n_->count - i - 1u ) * sizeof ( header * ) );
+                --n_->count;
+                if ( n_->type == kind::node16 and n_->count <= 3u )
+                    shrink<node4> ( ref_, n_ );
+                return;
+            }
+            case kind::node48: {
+                node48 * n                         = static_cast<node48 *> ( n_ );
+                n->children[ n->index[ b_ ] - 1u ] = nullptr;
+                n->index[ b_ ]                     = 0u;
+                if ( --n->count <= 12u )
+                    shrink<node16> ( ref_, n );
+                return;
+            }
+            case kind::node256: {
+                node256 * n       = static_cast<node256 *> ( n_ );
+                n->children[ b_ ] = nullptr;
+                if ( --n->count <= 37u )
+                    shrink<node48> ( ref_, n );
+                return;
+            }
+            default: assert ( false );
+        }
+    }
+
+    // Moves the children of n_ into a To, which is smaller and cannot throw as it is only ever called after a node was
+    // freed; if the arena has nothing in the size class though it may, in which case n_ simply stays as it is.
+    template<typename To>
+    void shrink ( header ** ref_, inner * n_ ) noexcept {
+        To * t;
+        try {
+            t = copy_header<To> ( n_ );
+        }
+        catch ( ... ) {
+            return;
+        }
+        unsigned char b = 0u;
+        for ( header * c = next_child ( n_, 0u, b ); c; c = b < 255u ? next_child ( n_, b + 1u, b ) : nullptr ) {
+            if constexpr ( std::is_same_v<To, node48> ) {
+                t->children[ t->count ] = c;
+                t->index[ b ]           = static_cast<std::uint8_t> ( ++t->count );
+            }
+            else {
+                t->keys[ t->count ]     = b;
+                t->children[ t->count ] = c;
+                ++t->count;
+            }
+        }
+        *ref_ = t;
+        free_node ( n_ );
+    }
+
+    // After a removal from *ref_: an inner node with just its terminal becomes that leaf, one with a single child and no
+    // terminal merges into it if their prefixes fit in one node.
+    void compact ( header ** ref_ ) noexcept {
+        inner * n = static_cast<inner *> ( *ref_ );
+        if ( not n->count ) {
+            assert ( n->terminal );
+            header * l = n->terminal;
+            l->set_prefix ( n->prefix, n->prefix_len );
+            *ref_ = l;
+            free_node ( n );
+            return;
+        }
+        if ( n->count != 1u or n->terminal )
+            return;
+        unsigned char b = 0u;
+        header * c      = next_child ( n, 0u, b );
+        std::size_t const m = n->prefix_len + 1u + c->prefix_len;
+        if ( m > max_prefix )
+            return;
+        unsigned char p[ max_prefix ];
+        std::memcpy ( p, n->prefix, n->prefix_len );
+        p[ n->prefix_len ] = b;
+        std::memcpy ( p + n->prefix_len + 1u, c->prefix, c->prefix_len );
+        c->set_prefix ( p, m );
+        *ref_ = c;
+        free_node ( n );
+    }
+
+    // Calls f_ ( leaf ) for every leaf, freeing the inner nodes as it goes (not to the arena, the caller resets it). The
+    // inner nodes still to be done are linked through their terminal field, so this needs neither a stack nor recursion.
+    template<typename Function>
+    void drain ( Function f_ ) {
+        inner * work = nullptr;
+        auto visit   = [ & ] ( header * n_ ) {
+            if ( n_->type == kind::leaf ) {
+                f_ ( static_cast<leaf *> ( n_ ) );
+                return;
+            }
+            inner * in = static_cast<inner *> ( n_ );
+            if ( in->terminal )
+                f_ ( static_cast<leaf *> ( in->terminal ) );
+            in->terminal = work;
+            work         = in;
+        };
+        if ( header * r = std::exchange ( m_root, nullptr ) )
+            visit ( r );
+        while ( work ) {
+            inner * n = work;
+            work      = static_cast<inner *> ( n->terminal );
+            unsigned char b = 0u;
+            for ( header * c = next_child ( n, 0u, b ); c; c = b < 255u ? next_child ( n, b + 1u, b ) : nullptr )
+                visit ( c );
+        }
+    }
+
+    void destroy_values ( ) noexcept {
+        if constexpr ( not std::is_trivially_destructible_v<value_type> )
+            drain ( [] ( leaf * l_ ) noexcept { l_->value ( )->~value_type ( ); } );
+    }
+
+    trie_arena<Allocator, max_node_size> m_arena;
+    header * m_root  = nullptr;
+    size_type m_size = 0u;
+};
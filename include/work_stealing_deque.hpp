@@ -0,0 +1,234 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <static_deque.hpp>
+
+#pragma once
+
+// A growable Chase-Lev work stealing deque (Le, Pop, Cohen, Zappa Nardelli, 2013). The owner pushes and pops at the bottom,
+// thieves steal from the top. The circular array is a map of ChunkSize element chunks, growing doubles the map and moves the
+// chunks over, only the chunk that holds both the first and the last elements (if any) is copied (into two new chunks). Thieves
+// may still read the old map, retired maps are freed by the owner once no thief is active.
+template<typename Type, std::size_t ChunkSize = 512u>
+class work_stealing_deque {
+
+    static_assert ( is_power_2 ( ChunkSize ), "Template parameter 2 must be an integral value with a value a power of 2" );
+    static_assert ( std::is_trivially_copyable_v<Type>, "Template parameter 1 must be trivially copyable" );
+
+    public:
+    using value_type    = Type;
+    using pointer       = value_type *;
+    using const_pointer = value_type const *;
+
+    using reference       = value_type &;
+    using const_reference = value_type const &;
+
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    static constexpr size_type chunck_size = ChunkSize;
+
+    explicit work_stealing_deque ( ) : m_buffer ( new buffer ( 1 ) ) {
+        m_buffer.load ( std::memory_order_relaxed )->map[ 0 ] = new chunk;
+    }
+
+    work_stealing_deque ( work_stealing_deque const & ) = delete;
+    work_stealing_deque & operator= ( work_stealing_deque const & ) = delete;
+
+    ~work_stealing_deque ( ) noexcept {
+        buffer * a = m_buffer.load ( std::memory_order_relaxed );
+        for ( size_type i = 0; i < a->chuncks; ++i )
+            delete a->map[ i ];
+        delete a;
+    }
+
+    // Owner.
+
+    void push ( value_type v_ ) {
+        difference_type const b = m_bottom.load ( std::memory_order_relaxed ), t = m_top.load ( std::memory_order_acquire );
+        buffer * a = m_buffer.load ( std::memory_order_relaxed );
+        if ( b - t > static_cast<difference_type> ( a->capacity ( ) ) - 1 )
+            a = grow ( a, t, b );
+        else if ( not m_retired.empty ( ) and not m_thieves.load ( std::memory_order_seq_cst ) )
+            m_retired.clear ( );
+        a->slot ( b ).store ( v_, std::memory_order_relaxed );
+        std::atomic_thread_fence ( std::memory_order_release );
+        m_bottom.store ( b + 1, std::memory_order_relaxed );
+    }
+
+    [[nodiscard]] std::optional<value_type> pop ( ) noexcept {
+        difference_type const b = m_bottom.load ( std::memory_order_relaxed ) - 1;
+        buffer * a              = m_buffer.load ( std::memory_order_relaxed );
+        m_bottom.store ( b, std::memory_order_relaxed );
+        std::atomic_thread_fence ( std::memory_order_seq_cst );
+        difference_type t = m_top.load ( std::memory_order_relaxed );
+        if ( t <= b ) {
+            value_type v = a->slot ( b ).load ( std::memory_order_relaxed );
+            if ( t == b ) {
+                // The last element, race the thieves for it.
+                bool const won = m_top.compare_exchange_strong ( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+                m_bottom.store ( b + 1, std::memory_order_relaxed );
+                if ( not won )
+                    return std::nullopt;
+            }
+            return v;
+        }
+        m_bottom.store ( b + 1, std::memory_order_relaxed );
+        return std::nullopt;
+    }
+
+    // Thieves.
+
+    // Returns std::nullopt if the deque is empty, or if another thread took the top element first.
+    [[nodiscard]] std::optional<value_type> steal ( ) noexcept {
+        thief_guard g ( m_thieves );
+        difference_type t = m_top.load ( std::memory_order_acquire );
+        std::atomic_thread_fence ( std::memory_order_seq_cst );
+        difference_type const b = m_bottom.load ( std::memory_order_acquire );
+        if ( t < b ) {
+            value_type v = m_buffer.load ( std::memory_order_seq_cst )->slot ( t ).load ( std::memory_order_relaxed );
+            if ( m_top.compare_exchange_strong ( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+                return v;
+        }
+        return std::nullopt;
+    }
+
+    // Steals (up to) half of the elements, writes them to o_ and returns their number. Every element is claimed with its own
+    // compare and swap, claiming a run at once would race with the owner popping without synchronization.
+    template<typename OutputIt>
+    [[maybe_unused]] size_type steal_half ( OutputIt o_ ) {
+        difference_type const t = m_top.load ( std::memory_order_acquire ), b = m_bottom.load ( std::memory_order_acquire );
+        size_type const n       = b > t ? static_cast<size_type> ( b - t + 1 ) / 2 : 0;
+        size_type i             = 0;
+        for ( ; i < n; ++i, ++o_ ) {
+            std::optional<value_type> v = steal ( );
+            if ( not v )
+                break;
+            *o_ = *v;
+        }
+        return i;
+    }
+
+    // Either side.
+
+    [[nodiscard]] size_type size_approx ( ) const noexcept {
+        difference_type const b = m_bottom.load ( std::memory_order_relaxed ), t = m_top.load ( std::memory_order_relaxed );
+        return b > t ? static_cast<size_type> ( b - t ) : 0;
+    }
+    [[nodiscard]] bool empty_approx ( ) const noexcept { return not size_approx ( ); }
+
+    private:
+    static constexpr int chunck_shift = log_power_2 ( ChunkSize );
+
+    struct chunk {
+        std::atomic<value_type> slots[ chunck_size ];
+    };
+
+    // The chunks are handed from buffer to buffer, a buffer only owns its map and, once retired, the chunk that did not go
+    // into the next map (see grow).
+    struct buffer {
+        size_type chuncks;
+        std::unique_ptr<chunk *[]> map;
+        std::unique_ptr<chunk> left_behind;
+
+        explicit buffer ( size_type c_ ) : chuncks ( c_ ), map ( new chunk *[ c_ ] ( ) ) {}
+
+        [[nodiscard]] size_type capacity ( ) const noexcept { return chuncks * chunck_size; }
+
+        // The chunk of block k_, i.e. of the positions [ k_ * chunck_size, ( k_ + 1 ) * chunck_size ).
+        [[nodiscard]] chunk *& block ( difference_type k_ ) const noexcept {
+            return map[ static_cast<size_type> ( k_ ) & ( chuncks - 1 ) ];
+        }
+
+        [[nodiscard]] std::atomic<value_type> & slot ( difference_type p_ ) const noexcept {
+            return block ( p_ >> chunck_shift )->slots[ static_cast<size_type> ( p_ ) & ( chunck_size - 1 ) ];
+        }
+    };
+
+    struct thief_guard {
+        std::atomic<size_type> & count;
+        explicit thief_guard ( std::atomic<size_type> & c_ ) noexcept : count ( c_ ) {
+            count.fetch_add ( 1, std::memory_order_seq_cst );
+        }
+        ~thief_guard ( ) noexcept { count.fetch_sub ( 1, std::memory_order_release ); }
+    };
+
+    // Called when the deque is full, i.e. the blocks of [ t_, b_ ) cover every chunk of a_. If t_ is not chunk aligned, the
+    // first and the last block share a chunk, which cannot go into the new map. A thief holding a_ may still read a position
+    // of the last block from it, while in the new map the owner reuses that slot for the block after the first one, as soon
+    // as the top has moved past the same slot in the first block. Both blocks are copied to new chunks instead, the shared
+    // chunk is freed with a_. Everything is allocated up front, if that throws nothing has changed.
+    [[nodiscard]] buffer * grow ( buffer * a_, difference_type t_, difference_type b_ ) {
+        difference_type const first = t_ >> chunck_shift, last = ( b_ - 1 ) >> chunck_shift;
+        bool const shared           = static_cast<size_type> ( last - first ) == a_->chuncks;
+        std::unique_ptr<buffer> n ( new buffer ( 2 * a_->chuncks ) );
+        std::vector<std::unique_ptr<chunk>> fresh ( n->chuncks - a_->chuncks + shared ); // The chunks not moved over.
+        for ( std::unique_ptr<chunk> & c : fresh )
+            c.reset ( new chunk );
+        m_retired.reserve ( m_retired.size ( ) + 1 );
+        auto const take = [ &fresh ] {
+            chunk * c = fresh.back ( ).release ( );
+            fresh.pop_back ( );
+            return c;
+        };
+        for ( difference_type k = first; k <= last; ++k )
+            n->block ( k ) = a_->block ( k );
+        if ( shared ) {
+            chunk * const s = a_->block ( first );
+            n->block ( first ) = copy_slots ( s, take ( ), static_cast<size_type> ( t_ ) & ( chunck_size - 1 ), chunck_size );
+            n->block ( last )  = copy_slots ( s, take ( ), 0, static_cast<size_type> ( b_ - ( last << chunck_shift ) ) );
+            a_->left_behind.reset ( s );
+        }
+        for ( size_type i = 0; i < n->chuncks; ++i )
+            if ( not n->map[ i ] )
+                n->map[ i ] = take ( );
+        m_retired.emplace_back ( a_ );
+        m_buffer.store ( n.get ( ), std::memory_order_seq_cst );
+        return n.release ( );
+    }
+
+    // Copies the slots [ f_, l_ ) of s_ to d_, returns d_.
+    static chunk * copy_slots ( chunk const * s_, chunk * d_, size_type f_, size_type l_ ) noexcept {
+        for ( size_type o = f_; o < l_; ++o )
+            d_->slots[ o ].store ( s_->slots[ o ].load ( std::memory_order_relaxed ), std::memory_order_relaxed );
+        return d_;
+    }
+
+    alignas ( 64 ) std::atomic<difference_type> m_top = 0;
+    alignas ( 64 ) std::atomic<difference_type> m_bottom = 0;
+    std::atomic<buffer *> m_buffer;
+    std::vector<std::unique_ptr<buffer>> m_retired; // Owner only.
+    alignas ( 64 ) std::atomic<size_type> m_thieves = 0;
+};
@@ -0,0 +1,310 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <trie.hpp>
+
+#include "trie.h"
+
+// The trie.h API on top of radix_trie. Values of up to slot_size bytes live in the leaves, larger ones in a block of their own
+// that the leaf points to. All memory, nodes included, comes from the routines set with trie_use_as_malloc ( ) and
+// trie_use_as_free ( ).
+
+namespace {
+
+trie_xalloc_t xalloc     = ::malloc;
+trie_xdealloc_t xdealloc = ::free;
+
+template<typename Type>
+struct hooked_allocator {
+
+    using value_type = Type;
+
+    hooked_allocator ( ) noexcept = default;
+    template<typename Other>
+    hooked_allocator ( hooked_allocator<Other> const & ) noexcept {}
+
+    [[nodiscard]] Type * allocate ( std::size_t n_ ) {
+        if ( void * p = xalloc ( n_ * sizeof ( Type ) ) )
+            return static_cast<Type *> ( p );
+        throw std::bad_alloc ( );
+    }
+    void deallocate ( Type * p_, std::size_t ) noexcept { xdealloc ( p_ ); }
+
+    template<typename Other>
+    [[nodiscard]] bool operator== ( hooked_allocator<Other> const & ) const noexcept {
+        return true;
+    }
+};
+
+constexpr std::size_t slot_size = sizeof ( std::max_align_t );
+
+struct slot {
+    alignas ( std::max_align_t ) unsigned char data[ slot_size ]{ };
+};
+
+[[nodiscard]] void * value ( trieb const * tr_, slot & s_ ) noexcept {
+    return tr_->sz > slot_size ? *reinterpret_cast<void **> ( s_.data ) : s_.data;
+}
+
+void destroy ( trieb const * tr_, slot & s_ ) noexcept {
+    if ( tr_->dtor )
+        tr_->dtor ( value ( tr_, s_ ), tr_->userp );
+    if ( tr_->sz > slot_size )
+        xdealloc ( *reinterpret_cast<void **> ( s_.data ) );
+}
+
+} // namespace
+
+using trie_type = radix_trie<slot, hooked_allocator<slot>>;
+
+struct trie_node {
+    trie_type trie;
+};
+
+// The root of the trie is created lazily and replaced by trie_clear ( ), the radix_trie cursor follows it.
+struct trie_cursor {
+    trieb * tr;
+    trie_node * node = nullptr;
+    std::optional<trie_type::cursor> cursor{ };
+};
+
+namespace {
+
+[[nodiscard]] trie_type::cursor * bind ( trie_cursor * cur_ ) {
+    if ( not cur_->tr->root )
+        return nullptr;
+    if ( cur_->node != cur_->tr->root or not cur_->cursor ) {
+        cur_->cursor.emplace ( cur_->tr->root->trie, cur_->tr->maxh + 1u );
+        cur_->node = cur_->tr->root;
+    }
+    return &*cur_->cursor;
+}
+
+// Calls f_ ( cursor ) and handles the result, the cursor is dropped if that failed.
+template<typename Function>
+int move ( trie_cursor * cur_, Function f_ ) {
+    try {
+        trie_type::cursor * c = bind ( cur_ );
+        return c and f_ ( *c );
+    }
+    catch ( std::bad_alloc const & ) {
+        cur_->cursor.reset ( );
+        return 0;
+    }
+}
+
+} // namespace
+
+void * ( trie_setp ) ( trieb * tr, char const * key ) {
+    std::string_view const k ( key );
+    try {
+        if ( not tr->root )
+            tr->root = ::new ( hooked_allocator<trie_node> ( ).allocate ( 1u ) ) trie_node{ };
+        auto [ s, inserted ] = tr->root->trie.try_emplace ( k );
+        if ( inserted ) {
+            if ( tr->sz > slot_size ) {
+                void * p = xalloc ( tr->sz );
+                if ( not p ) {
+                    tr->root->trie.erase ( k );
+                    return nullptr;
+                }
+                std::memset ( p, 0, tr->sz );
+                *reinterpret_cast<void **> ( s->data ) = p;
+            }
+            tr->size += 1u;
+            tr->maxh = std::max ( tr->maxh, k.size ( ) );
+        }
+        return value ( tr, *s );
+    }
+    catch ( std::bad_alloc const & ) {
+        return nullptr;
+    }
+}
+
+void * ( trie_getp ) ( trieb * tr, char const * key ) {
+    if ( not tr->root )
+        return nullptr;
+    slot * s = tr->root->trie.find ( key );
+    return s ? value ( tr, *s ) : nullptr;
+}
+
+std::size_t ( trie_getp_many ) ( trieb * tr, char const * const * keys, std::size_t n, void ** out ) {
+    if ( not tr->root ) {
+        std::fill ( out, out + n, nullptr );
+        return 0u;
+    }
+    constexpr std::size_t batch = 64u;
+    std::string_view k[ batch ];
+    slot * s[ batch ];
+    std::size_t found = 0u;
+    for ( std::size_t b = 0u; b < n; b += batch ) {
+        std::size_t const m = std::min ( batch, n - b );
+        std::copy ( keys + b, keys + b + m, k );
+        tr->root->trie.find_many ( k, m, s );
+        for ( std::size_t i = 0u; i < m; ++i ) {
+            out[ b + i ] = s[ i ] ? value ( tr, *s[ i ] ) : nullptr;
+            found += s[ i ] != nullptr;
+        }
+    }
+    return found;
+}
+
+int ( trie_cut ) ( trieb * tr, char const * key ) {
+    if ( not tr->root )
+        return 0;
+    slot * s = tr->root->trie.find ( key );
+    if ( not s )
+        return 0;
+    destroy ( tr, *s );
+    tr->root->trie.erase ( key );
+    tr->size -= 1u;
+    return 1;
+}
+
+int ( trie_iter ) ( trieb * tr, trie_itercb_t func, void * userp ) {
+    if ( not tr->root )
+        return 1;
+    // The keys are taken first, as func may cut the key it is called with.
+    std::basic_string<char, std::char_traits<char>, hooked_allocator<char>> keys;
+    try {
+        keys.reserve ( tr->size * 8u );
+        tr->root->trie.for_each ( [ &keys ] ( std::string_view k_, slot & ) {
+            keys.append ( k_ );
+            keys.push_back ( '\0' );
+        } );
+    }
+    catch ( std::bad_alloc const & ) {
+        return 0;
+    }
+    for ( char const *k = keys.data ( ), *e = k + keys.size ( ); k != e; k += std::strlen ( k ) + 1u )
+        if ( slot * s = tr->root->trie.find ( k ) )
+            func ( k, value ( tr, *s ), userp );
+    return 1;
+}
+
+// Builds a new root and only swaps it in once that worked, a failed call leaves tr as it was.
+int ( trie_build_sorted ) ( trieb * tr, char const * const * keys, void const * values, std::size_t n ) {
+    trie_node * root = nullptr;
+    std::vector<std::string_view, hooked_allocator<std::string_view>> k;
+    std::vector<void *, hooked_allocator<void *>> blocks; // Of the large values, allocated up front so that they can be freed.
+    try {
+        k.assign ( keys, keys + n );
+        if ( tr->sz > slot_size ) {
+            blocks.reserve ( n );
+            for ( std::size_t i = 0u; i < n; ++i ) {
+                blocks.push_back ( xalloc ( tr->sz ) );
+                if ( not blocks.back ( ) )
+                    throw std::bad_alloc ( );
+            }
+        }
+        root = ::new ( hooked_allocator<trie_node> ( ).allocate ( 1u ) ) trie_node{ };
+        root->trie.build_sorted ( k.data ( ), n, [ & ] ( std::size_t i_ ) {
+            slot s;
+            void * v = s.data;
+            if ( tr->sz > slot_size )
+                v = *reinterpret_cast<void **> ( s.data ) = blocks[ i_ ];
+            if ( values )
+                std::memcpy ( v, static_cast<char const *> ( values ) + i_ * tr->sz, tr->sz );
+            else
+                std::memset ( v, 0, tr->sz );
+            return s;
+        } );
+    }
+    catch ( std::exception const & ) { // Out of memory, or the keys are not strictly increasing.
+        for ( void * b : blocks )
+            xdealloc ( b );
+        trie_destroynode ( tr, root ); // Empty, a failed build_sorted ( ) clears it.
+        return 0;
+    }
+    trie_destroynode ( tr, std::exchange ( tr->root, root ) );
+    tr->size = n;
+    tr->maxh = 0u;
+    for ( std::string_view const s : k )
+        tr->maxh = std::max ( tr->maxh, s.size ( ) );
+    return 1;
+}
+
+// The leaves are only visited if there is a dtor to call or a block to free, otherwise the arena is reset in one go.
+void trie_destroynode ( trieb * tr, trie_node * node ) {
+    if ( not node )
+        return;
+    if ( tr->dtor or tr->sz > slot_size )
+        node->trie.consume ( [ tr ] ( slot & s_ ) { destroy ( tr, s_ ); } );
+    else
+        node->trie.clear ( );
+    node->~trie_node ( );
+    hooked_allocator<trie_node> ( ).deallocate ( node, 1u );
+}
+
+void trie_cb_freevoidptr ( void * buf, void * ) { xdealloc ( *static_cast<void **> ( buf ) ); }
+void trie_cb_freecharptr ( void * buf, void * ) { xdealloc ( *static_cast<char **> ( buf ) ); }
+
+void trie_use_as_malloc ( trie_xalloc_t routine ) { xalloc = routine ? routine : ::malloc; }
+void trie_use_as_free ( trie_xdealloc_t routine ) { xdealloc = routine ? routine : ::free; }
+
+trie_cursor * ( trie_cursor_new ) ( trieb * tr ) {
+    try {
+        return ::new ( hooked_allocator<trie_cursor> ( ).allocate ( 1u ) ) trie_cursor{ tr };
+    }
+    catch ( std::bad_alloc const & ) {
+        return nullptr;
+    }
+}
+
+void trie_cursor_free ( trie_cursor * cur ) {
+    if ( not cur )
+        return;
+    cur->~trie_cursor ( );
+    hooked_allocator<trie_cursor> ( ).deallocate ( cur, 1u );
+}
+
+int trie_prefix_iter ( trie_cursor * cur, char const * prefix ) {
+    return move ( cur, [ prefix ] ( trie_type::cursor & c_ ) { return c_.seek_prefix ( prefix ); } );
+}
+
+int trie_lower_bound ( trie_cursor * cur, char const * key ) {
+    return move ( cur, [ key ] ( trie_type::cursor & c_ ) { return c_.seek ( key ); } );
+}
+
+int trie_cursor_next ( trie_cursor * cur ) {
+    return cur->cursor and cur->cursor->valid ( ) ? move ( cur, [] ( trie_type::cursor & c_ ) { return c_.next ( ); } ) : 0;
+}
+
+char const * trie_cursor_key ( trie_cursor const * cur ) {
+    return cur->cursor and cur->cursor->valid ( ) ? cur->cursor->c_str ( ) : nullptr;
+}
+
+void * trie_cursor_value ( trie_cursor const * cur ) {
+    return cur->cursor and cur->cursor->valid ( ) ? value ( cur->tr, cur->cursor->value ( ) ) : nullptr;
+}
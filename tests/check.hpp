@@ -0,0 +1,59 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <exception>
+
+#include <sax/splitmix.hpp>
+
+#pragma once
+
+// The tests are plain executables, a failed check prints where it failed and aborts, which ctest reports as a failure.
+
+[[noreturn]] inline void check_failed ( char const * expr_, char const * file_, int line_ ) noexcept {
+    std::fprintf ( stderr, "%s:%d: check failed: %s\n", file_, line_, expr_ );
+    std::abort ( );
+}
+
+#define CHECK( ... ) ( ( __VA_ARGS__ ) ? void ( 0 ) : check_failed ( #__VA_ARGS__, __FILE__, __LINE__ ) )
+
+// True if f_ ( ) throws an Exception.
+template<typename Exception, typename Function>
+[[nodiscard]] bool throws ( Function f_ ) {
+    try {
+        f_ ( );
+    }
+    catch ( Exception const & ) {
+        return true;
+    }
+    return false;
+}
+
+// A value in [ 0, n_ ).
+[[nodiscard]] inline std::size_t below ( sax::splitmix64 & rng_, std::size_t n_ ) noexcept {
+    return static_cast<std::size_t> ( rng_ ( ) % n_ );
+}
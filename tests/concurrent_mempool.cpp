@@ -0,0 +1,119 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <concurrent_queue.hpp>
+#include <mempool.hpp>
+
+#include "check.hpp"
+
+// Objects are stamped by who allocated them, a slot that is handed out twice gets stamped twice, which the thread sanitizer
+// reports as a race and the check of the stamp catches.
+struct stamped {
+    std::uint32_t thread, sequence;
+    std::uint64_t check;
+
+    stamped ( std::uint32_t t_, std::uint32_t s_ ) noexcept : thread ( t_ ), sequence ( s_ ), check ( hash ( t_, s_ ) ) {}
+
+    [[nodiscard]] static std::uint64_t hash ( std::uint32_t t_, std::uint32_t s_ ) noexcept {
+        return ( std::uint64_t{ t_ } << 32 | s_ ) * 0x9e3779b97f4a7c15ull;
+    }
+    [[nodiscard]] bool intact ( ) const noexcept { return check == hash ( thread, sequence ); }
+};
+
+using pool = concurrent_mempool<stamped, std::uint32_t, 1'024u, 8u>;
+
+constexpr std::size_t threads = 4u, per_thread = 20'000u;
+
+// Half the threads allocate and pass the objects on, the other half check and free them, so the slots keep moving from
+// the magazines of the one to the magazines of the other, through the depot. Every round starts new threads, the magazines
+// of the threads that went away are picked up by the new ones.
+void producers_and_consumers ( ) {
+    for ( int round = 0; round < 3; ++round ) {
+        mpmc_queue<stamped *> q ( 256u );
+        std::atomic<std::size_t> left = threads / 2u * per_thread;
+        std::vector<std::thread> t;
+        for ( std::uint32_t i = 0; i < threads; ++i )
+            t.emplace_back ( [ & q, & left, i ] {
+                if ( i % 2u ) {
+                    for ( std::uint32_t s = 0; s < per_thread; ++s ) {
+                        stamped * p = ::new ( pool::allocate ( ) ) stamped ( i, s );
+                        while ( not q.try_push ( std::move ( p ) ) )
+                            std::this_thread::yield ( );
+                    }
+                }
+                else {
+                    stamped * p;
+                    while ( left.load ( std::memory_order_relaxed ) ) {
+                        if ( not q.try_pop ( p ) ) {
+                            std::this_thread::yield ( );
+                            continue;
+                        }
+                        left.fetch_sub ( 1u, std::memory_order_relaxed );
+                        CHECK ( p->intact ( ) and p->thread % 2u );
+                        pool::deallocate ( p );
+                    }
+                }
+            } );
+        for ( std::thread & i : t )
+            i.join ( );
+    }
+}
+
+// Every thread allocates and frees its own objects, a batch of distinct live objects at a time.
+void thread_local_batches ( ) {
+    std::vector<std::thread> t;
+    for ( std::uint32_t i = 0; i < threads; ++i )
+        t.emplace_back ( [ i ] {
+            sax::splitmix64 rng ( i );
+            std::vector<stamped *> live;
+            for ( std::uint32_t s = 0; s < per_thread; ++s ) {
+                if ( live.empty ( ) or below ( rng, 2 ) ) {
+                    live.push_back ( ::new ( pool::allocate ( ) ) stamped ( i, s ) );
+                }
+                else {
+                    CHECK ( live.back ( )->intact ( ) and live.back ( )->thread == i );
+                    pool::deallocate ( live.back ( ) );
+                    live.pop_back ( );
+                }
+            }
+            for ( stamped * p : live )
+                pool::deallocate ( p );
+            pool::flush ( );
+        } );
+    for ( std::thread & i : t )
+        i.join ( );
+}
+
+int main ( ) {
+    producers_and_consumers ( );
+    thread_local_batches ( );
+    return EXIT_SUCCESS;
+}
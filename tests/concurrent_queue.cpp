@@ -0,0 +1,136 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <concurrent_queue.hpp>
+
+#include "check.hpp"
+
+constexpr std::size_t values = 100'000u;
+
+// The consumer sees every value once and in order, single and bulk operations mixed, values left behind are destroyed by
+// the queue.
+void spsc ( ) {
+    spsc_queue<std::string, 16u> q;
+    std::thread consumer ( [ &q ] {
+        sax::splitmix64 rng ( 2 );
+        std::vector<std::string> b ( 40 );
+        for ( std::size_t next = 0; next < values; ) {
+            std::size_t n = 0;
+            if ( below ( rng, 2 ) )
+                n = q.try_pop ( b[ 0 ] );
+            else
+                n = q.try_pop_bulk ( b.begin ( ), 1 + below ( rng, b.size ( ) ) );
+            if ( not n )
+                std::this_thread::yield ( );
+            for ( std::size_t i = 0; i < n; ++i )
+                CHECK ( b[ i ] == std::to_string ( next++ ) );
+        }
+    } );
+    sax::splitmix64 rng ( 1 );
+    std::vector<std::string> b;
+    for ( std::size_t v = 0; v < values; ) {
+        if ( below ( rng, 2 ) ) {
+            q.push ( std::to_string ( v++ ) );
+        }
+        else {
+            b.clear ( );
+            for ( std::size_t n = std::min ( values - v, 1 + below ( rng, 40 ) ); n--; )
+                b.push_back ( std::to_string ( v++ ) );
+            q.push_bulk ( b.begin ( ), b.size ( ) );
+        }
+        if ( not below ( rng, 64 ) )
+            std::this_thread::yield ( );
+    }
+    consumer.join ( );
+    for ( int i = 0; i < 100; ++i )
+        q.push ( std::string ( 100, 'x' ) );
+    CHECK ( q.size_approx ( ) == 100u );
+}
+
+struct message {
+    std::uint32_t producer, sequence;
+};
+
+constexpr std::size_t producers = 3u, consumers = 3u;
+
+// Every message arrives once, and a consumer sees the messages of each producer in the order they were sent.
+void mpmc ( ) {
+    mpmc_queue<message, 16u> q ( 64u );
+    CHECK ( q.capacity ( ) == 64u );
+    std::unique_ptr<std::atomic<std::uint8_t>[]> seen ( new std::atomic<std::uint8_t>[ producers * values ] ( ) );
+    std::atomic<std::size_t> left = producers * values;
+    std::vector<std::thread> t;
+    for ( std::uint32_t i = 0; i < producers; ++i )
+        t.emplace_back ( [ &q, i ] {
+            sax::splitmix64 rng ( i );
+            message b[ 8 ];
+            for ( std::uint32_t s = 0; s < values; ) {
+                std::size_t n = std::min<std::size_t> ( values - s, 1 + below ( rng, 8 ) );
+                for ( std::size_t j = 0; j < n; ++j )
+                    b[ j ] = { i, static_cast<std::uint32_t> ( s + j ) };
+                n = n == 1u ? q.try_push ( b[ 0 ] ) : q.try_push_bulk ( b, n );
+                if ( not n )
+                    std::this_thread::yield ( );
+                s += static_cast<std::uint32_t> ( n );
+            }
+        } );
+    for ( std::uint32_t i = 0; i < consumers; ++i )
+        t.emplace_back ( [ &q, &seen, &left, i ] {
+            sax::splitmix64 rng ( 10 + i );
+            std::int64_t last[ producers ];
+            std::fill ( std::begin ( last ), std::end ( last ), -1 );
+            message b[ 8 ];
+            while ( left.load ( std::memory_order_relaxed ) ) {
+                std::size_t const n = below ( rng, 2 ) ? q.try_pop ( b[ 0 ] ) : q.try_pop_bulk ( b, 1 + below ( rng, 8 ) );
+                if ( not n )
+                    std::this_thread::yield ( );
+                for ( std::size_t j = 0; j < n; ++j ) {
+                    CHECK ( b[ j ].producer < producers and b[ j ].sequence < values );
+                    CHECK ( last[ b[ j ].producer ] < b[ j ].sequence );
+                    last[ b[ j ].producer ] = b[ j ].sequence;
+                    CHECK ( not seen[ b[ j ].producer * values + b[ j ].sequence ].fetch_add ( 1u ) );
+                }
+                left.fetch_sub ( n, std::memory_order_relaxed );
+            }
+        } );
+    for ( std::thread & i : t )
+        i.join ( );
+    CHECK ( q.size_approx ( ) == 0u );
+}
+
+int main ( ) {
+    spsc ( );
+    mpmc ( );
+    return EXIT_SUCCESS;
+}
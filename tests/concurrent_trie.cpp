@@ -0,0 +1,116 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <concurrent_trie.hpp>
+
+#include "check.hpp"
+
+constexpr std::size_t writers = 2u, readers = 3u, keys_per_writer = 300u, writes = 20'000u;
+
+// Keys share prefixes longer than a node holds, the writers each own the keys that start with their digit.
+[[nodiscard]] std::string key ( std::size_t writer_, std::size_t i_ ) {
+    return std::to_string ( writer_ ) + "/a_rather_long_shared_prefix/" + std::to_string ( i_ % 17u ) + '/' + std::to_string ( i_ );
+}
+
+// A value carries its key, a reader that sees a value that does not go with the key has read a torn or freed one.
+[[nodiscard]] std::string value ( std::string_view key_, std::size_t version_ ) {
+    return std::string ( key_ ) + '#' + std::to_string ( version_ );
+}
+
+// Writers insert, replace and erase while readers look keys up. Afterwards the trie holds what the writers think it holds.
+void readers_and_writers ( ) {
+    concurrent_trie<std::string> t;
+    std::atomic<bool> done = false;
+    std::vector<std::map<std::string, std::string>> models ( writers );
+    std::vector<std::thread> threads;
+    for ( std::size_t w = 0; w < writers; ++w )
+        threads.emplace_back ( [ &t, &models, w ] {
+            sax::splitmix64 rng ( w );
+            std::map<std::string, std::string> & m = models[ w ];
+            for ( std::size_t i = 0; i < writes; ++i ) {
+                std::string const k = key ( w, below ( rng, keys_per_writer ) );
+                switch ( below ( rng, 4 ) ) {
+                    case 0: CHECK ( t.erase ( k ) == ( m.erase ( k ) == 1u ) ); break;
+                    case 1: {
+                        std::string const v = value ( k, i );
+                        CHECK ( t.try_emplace ( k, v ) == m.try_emplace ( k, v ).second );
+                    } break;
+                    default: {
+                        std::string const v = value ( k, i );
+                        CHECK ( t.insert_or_assign ( k, v ) == m.insert_or_assign ( k, v ).second );
+                    } break;
+                }
+                if ( not below ( rng, 64 ) )
+                    std::this_thread::yield ( );
+            }
+        } );
+    for ( std::size_t r = 0; r < readers; ++r )
+        threads.emplace_back ( [ &t, &done, r ] {
+            sax::splitmix64 rng ( 100 + r );
+            while ( not done.load ( std::memory_order_relaxed ) ) {
+                std::string const k = key ( below ( rng, writers ), below ( rng, keys_per_writer ) );
+                t.visit ( k, [ &k ] ( std::string const & v_ ) { CHECK ( v_.compare ( 0, k.size ( ) + 1u, k + '#' ) == 0 ); } );
+                if ( std::optional<std::string> v = t.find ( k ) )
+                    CHECK ( v->compare ( 0, k.size ( ) + 1u, k + '#' ) == 0 );
+                if ( not below ( rng, 64 ) )
+                    std::this_thread::yield ( );
+            }
+        } );
+    for ( std::size_t w = 0; w < writers; ++w )
+        threads[ w ].join ( );
+    done.store ( true, std::memory_order_relaxed );
+    for ( std::size_t r = writers; r < threads.size ( ); ++r )
+        threads[ r ].join ( );
+
+    std::size_t size = 0;
+    for ( std::size_t w = 0; w < writers; ++w ) {
+        size += models[ w ].size ( );
+        for ( std::size_t i = 0; i < keys_per_writer; ++i ) {
+            std::string const k          = key ( w, i );
+            std::optional<std::string> v = t.find ( k );
+            auto const j                 = models[ w ].find ( k );
+            CHECK ( j == models[ w ].end ( ) ? not v : v and *v == j->second );
+        }
+    }
+    CHECK ( t.size ( ) == size );
+    t.reclaim ( );
+    t.clear ( );
+    CHECK ( t.empty ( ) and not t.contains ( key ( 0u, 0u ) ) );
+}
+
+int main ( ) {
+    readers_and_writers ( );
+    return EXIT_SUCCESS;
+}
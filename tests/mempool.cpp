@@ -0,0 +1,219 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <memory_resource>
+#include <new>
+#include <set>
+#include <vector>
+
+#include <mempool.hpp>
+
+#include "check.hpp"
+
+// While out_of_memory is set, every operator new throws.
+
+inline bool out_of_memory = false;
+
+void * operator new ( std::size_t n_ ) {
+    if ( void * p = out_of_memory ? nullptr : std::malloc ( n_ ? n_ : 1u ) )
+        return p;
+    throw std::bad_alloc ( );
+}
+void * operator new ( std::size_t n_, std::align_val_t a_ ) {
+    std::size_t const a = static_cast<std::size_t> ( a_ );
+    if ( void * p = out_of_memory ? nullptr : std::aligned_alloc ( a, ( n_ + a - 1u ) & ~( a - 1u ) ) )
+        return p;
+    throw std::bad_alloc ( );
+}
+void operator delete ( void * p_ ) noexcept { std::free ( p_ ); }
+void operator delete ( void * p_, std::size_t ) noexcept { std::free ( p_ ); }
+void operator delete ( void * p_, std::align_val_t ) noexcept { std::free ( p_ ); }
+void operator delete ( void * p_, std::size_t, std::align_val_t ) noexcept { std::free ( p_ ); }
+
+struct record {
+    std::uint64_t a, b, c;
+    std::uint32_t d;
+};
+
+// Slots are distinct, aligned, inside a chunk, and come back after a deallocation.
+void pool ( ) {
+    using pool_type = mempool<record, std::uint32_t>;
+    static_assert ( pool_type::chunck_bytes == pool_chunk_layout<pool_type::slot_size>::bytes );
+    static_assert ( pool_type::header_size + pool_type::chunck_size * pool_type::slot_size + pool_type::tail_waste ==
+                    pool_type::chunck_bytes );
+    pool_type p;
+    sax::splitmix64 rng ( 0x9001 );
+    std::vector<record *> live;
+    std::set<record *> seen;
+    for ( int op = 0; op < 20'000; ++op ) {
+        if ( live.empty ( ) or below ( rng, 3 ) ) {
+            std::vector<record *> r ( 1 + below ( rng, 40 ) );
+            if ( below ( rng, 2 ) )
+                p.allocate_n ( r.data ( ), static_cast<std::uint32_t> ( r.size ( ) ) );
+            else
+                std::generate ( r.begin ( ), r.end ( ), [ &p ] { return p.allocate ( ); } );
+            for ( record * s : r ) {
+                CHECK ( not ( reinterpret_cast<std::uintptr_t> ( s ) % alignof ( record ) ) );
+                CHECK ( seen.insert ( s ).second );
+                *s = { 1u, 2u, 3u, 4u };
+            }
+            live.insert ( live.end ( ), r.begin ( ), r.end ( ) );
+        }
+        else {
+            std::size_t const n = 1 + below ( rng, live.size ( ) );
+            std::vector<record *> r ( live.end ( ) - static_cast<std::ptrdiff_t> ( n ), live.end ( ) );
+            live.resize ( live.size ( ) - n );
+            for ( record * s : r )
+                seen.erase ( s );
+            if ( below ( rng, 2 ) )
+                p.deallocate_n ( r.data ( ), static_cast<std::uint32_t> ( r.size ( ) ) );
+            else
+                for ( record * s : r )
+                    p.deallocate ( s );
+        }
+    }
+    // All slots that were ever handed out came from at most this many chunks.
+    CHECK ( p.chunks ( ) * pool_type::chunck_size >= live.size ( ) );
+    std::size_t const chunks = p.chunks ( );
+    for ( record * s : live )
+        p.deallocate ( s );
+    for ( std::size_t i = 0; i < live.size ( ); ++i )
+        (void) p.allocate ( );
+    CHECK ( p.chunks ( ) == chunks );
+    p.release ( );
+    CHECK ( not p.chunks ( ) );
+}
+
+// The chunks stay linked both ways through grow ( ), pop_back ( ), shrink ( ) and a move, and a long chain is released without
+// recursing once per chunk.
+void chunks ( ) {
+    using pool_type = mempool<std::uint64_t, std::uint32_t, 256u>;
+    auto linked     = [] ( pool_type const & p_ ) {
+        std::size_t n = 0u;
+        for ( auto * c = p_.back ( ); c; c = c->m_prev, ++n )
+            CHECK ( c->m_prev ? c->m_prev->m_next.get ( ) == c : p_.m_last_data.get ( ) == c );
+        return n == p_.chunks ( );
+    };
+    pool_type p;
+    for ( int i = 0; i < 10; ++i )
+        CHECK ( p.grow ( ) == p.back ( ) );
+    CHECK ( p.chunks ( ) == 10u and linked ( p ) );
+    std::uint64_t * s = p.allocate ( ); // Carved from a fresh chunk at the back.
+    *s                = 1u;
+    p.pop_back ( );
+    CHECK ( p.chunks ( ) == 10u and linked ( p ) ); // The slot came from an 11th chunk.
+    p.shrink ( 4u );
+    CHECK ( p.chunks ( ) == 4u and linked ( p ) );
+    p.shrink ( 8u );
+    CHECK ( p.chunks ( ) == 4u );
+    pool_type q ( std::move ( p ) );
+    CHECK ( not p.chunks ( ) and not p.back ( ) and q.chunks ( ) == 4u and linked ( q ) );
+    *q.allocate ( ) = 2u;
+    CHECK ( q.chunks ( ) == 5u and linked ( q ) );
+    for ( int i = 0; i < 100'000; ++i )
+        (void) q.grow ( );
+    CHECK ( linked ( q ) );
+}
+
+// After a burst is deallocated, shrinking drops the free slots of the released chunks, the next allocations come from chunks
+// that are still there (under ASan a stale free slot is a use after free).
+void shrink_after_burst ( ) {
+    using pool_type = mempool<std::uint64_t, std::uint32_t, 256u>;
+    pool_type p;
+    std::vector<std::uint64_t *> r ( 10 * pool_type::chunck_size );
+    for ( int round = 0; round < 3; ++round ) {
+        std::size_t const n = round ? r.size ( ) / 2 : r.size ( );
+        p.allocate_n ( r.data ( ), static_cast<std::uint32_t> ( n ) );
+        p.deallocate_n ( r.data ( ), static_cast<std::uint32_t> ( n ) );
+        p.shrink ( round == 1 ? 2u : 0u );
+        CHECK ( p.chunks ( ) <= 2u );
+        for ( std::size_t i = 0; i < r.size ( ); ++i )
+            *( r[ i ] = p.allocate ( ) ) = i;
+        for ( std::size_t i = 0; i < r.size ( ); ++i )
+            CHECK ( *r[ i ] == i );
+        for ( std::uint64_t * s : r )
+            p.deallocate ( s );
+    }
+}
+
+// Blocks do not overlap, large and over-aligned ones go upstream.
+void resource ( ) {
+    std::pmr::monotonic_buffer_resource upstream;
+    mempool_resource<> r ( &upstream );
+    std::pmr::vector<std::pmr::vector<int>> v ( &r );
+    sax::splitmix64 rng ( 0xbeef );
+    for ( int i = 0; i < 2'000; ++i ) {
+        v.emplace_back ( below ( rng, 300 ), i );
+        if ( below ( rng, 3 ) == 0 )
+            v.erase ( v.begin ( ) + static_cast<std::ptrdiff_t> ( below ( rng, v.size ( ) ) ) );
+    }
+    for ( auto const & w : v )
+        CHECK ( std::all_of ( w.begin ( ), w.end ( ), [ &w ] ( int i_ ) { return i_ == w.front ( ); } ) );
+    void * p = r.allocate ( 64u, 64u );
+    CHECK ( not ( reinterpret_cast<std::uintptr_t> ( p ) % 64u ) );
+    r.deallocate ( p, 64u, 64u );
+}
+
+// Running out of memory throws std::bad_alloc and leaves the pools as they were.
+void out_of_memory_throws ( ) {
+    using pool_type = mempool<record, std::uint32_t>;
+    pool_type p;
+    std::vector<record *> r ( pool_type::chunck_size + 1u );
+    out_of_memory = true;
+    CHECK ( throws<std::bad_alloc> ( [ & ] { (void) p.allocate ( ); } ) );
+    out_of_memory = false;
+    p.allocate_n ( r.data ( ), pool_type::chunck_size - 1u );
+    out_of_memory = true;
+    record * q[ 2 ];
+    CHECK ( throws<std::bad_alloc> ( [ & ] { p.allocate_n ( q, 2u ); } ) );
+    out_of_memory = false;
+    p.allocate_n ( r.data ( ) + pool_type::chunck_size - 1u, 2u );
+    CHECK ( p.chunks ( ) == 2u );
+    std::sort ( r.begin ( ), r.end ( ) );
+    CHECK ( std::adjacent_find ( r.begin ( ), r.end ( ) ) == r.end ( ) );
+
+    mempool_resource<> m ( std::pmr::null_memory_resource ( ) );
+    std::set<void *> blocks;
+    for ( std::size_t i = 0; i < mempool_resource<>::pool_type::aligned_stack_storage::capacity ( ) / 64u; ++i )
+        blocks.insert ( m.allocate ( 64u ) );
+    out_of_memory = true;
+    CHECK ( throws<std::bad_alloc> ( [ & ] { (void) m.allocate ( 64u ); } ) );
+    out_of_memory = false;
+    for ( int i = 0; i < 100; ++i )
+        CHECK ( blocks.insert ( m.allocate ( 48u ) ).second );
+}
+
+int main ( ) {
+    pool ( );
+    chunks ( );
+    shrink_after_burst ( );
+    resource ( );
+    out_of_memory_throws ( );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <offset_ptr.hpp>
+
+#include "check.hpp"
+
+// Relocating the bytes of a structure linked with offset_ptr's keeps it linked, copying one offset_ptr keeps its pointee.
+void self_relative ( ) {
+    struct list {
+        int value[ 8 ];
+        offset_ptr<int> first, last;
+        offset_ptr<int, std::int16_t> narrow;
+    };
+    list a{ { 0, 1, 2, 3, 4, 5, 6, 7 }, nullptr, nullptr, nullptr };
+    CHECK ( not a.first and a.first == nullptr and a.first.offset ( ) == offset_ptr<int>::null_offset );
+    a.first  = a.value;
+    a.last   = a.value + 7;
+    a.narrow = a.value + 3;
+    CHECK ( a.first < a.last and *a.last == 7 and *a.narrow == 3 );
+    alignas ( list ) unsigned char b[ sizeof ( list ) ];
+    std::memcpy ( b, &a, sizeof ( list ) );
+    list const & c = *reinterpret_cast<list const *> ( b );
+    CHECK ( c.first.get ( ) == c.value and c.last.get ( ) == c.value + 7 and c.narrow.get ( ) == c.value + 3 );
+    offset_ptr<int> d ( a.last ); // Another address, another offset, the same pointee.
+    CHECK ( d == a.last and d.offset ( ) != a.last.offset ( ) );
+    d.swap ( a.first );
+    CHECK ( *d == 0 and *a.first == 7 );
+    offset_ptr<int const> const e ( d );
+    CHECK ( e.get ( ) == a.value );
+    static struct {
+        offset_ptr<char, std::int16_t> p;
+        char bytes[ 40'000 ];
+    } g;
+    CHECK ( g.p.reaches ( nullptr ) and not g.p.reaches ( reinterpret_cast<char *> ( &g.p ) + 1 ) ); // That is the null offset.
+    CHECK ( g.p.reaches ( g.bytes + 30'000 ) and not g.p.reaches ( g.bytes + 33'000 ) );
+}
+
+// Copying a whole chunk to another chunk keeps the links within it.
+void chunk_relative ( ) {
+    struct node {
+        chunk_ptr<node, 256u> next;
+        std::uint32_t value;
+    };
+    static_assert ( sizeof ( node ) == 8u );
+    struct alignas ( 256 ) chunk {
+        node nodes[ 32 ];
+    };
+    chunk * a = new chunk{ }, * b = new chunk;
+    for ( std::uint32_t i = 0u; i < 32u; ++i ) {
+        a->nodes[ i ].value = i;
+        a->nodes[ i ].next  = i ? a->nodes + i - 1 : nullptr;
+    }
+    CHECK ( a->nodes[ 0 ].next.reaches ( a->nodes + 31 ) and not a->nodes[ 0 ].next.reaches ( b->nodes ) );
+    std::memcpy ( static_cast<void *> ( b ), a, sizeof ( chunk ) );
+    std::uint32_t v = 32u;
+    for ( node const * n = b->nodes + 31; n; n = n->next.get ( ) )
+        CHECK ( n->value == --v and ( n == b->nodes or n->next.get ( ) == n - 1 ) );
+    CHECK ( v == 0u );
+    delete a;
+    delete b;
+}
+
+int main ( ) {
+    self_relative ( );
+    chunk_relative ( );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <filesystem>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <offset_ptr.hpp>
+#include <pool_image.hpp>
+
+#include "check.hpp"
+
+struct node {
+    offset_ptr<node> next;
+    std::uint32_t value = 0u;
+};
+
+using arena = aligned_stack_storage_<4'096u, 64u, overflow_policy::fail>;
+
+[[nodiscard]] std::string temp_path ( char const * name_ ) {
+    return ( std::filesystem::temp_directory_path ( ) / name_ ).string ( );
+}
+
+// The system error an image path_ fails with, or 0 if it fails as an invalid image.
+[[nodiscard]] int open_error ( std::string const & path_ ) {
+    try {
+        pool_image i ( path_.c_str ( ) );
+    }
+    catch ( std::system_error const & e ) {
+        return e.code ( ).value ( );
+    }
+    catch ( std::runtime_error const & ) {
+        return 0;
+    }
+    CHECK ( false );
+    return -1;
+}
+
+// A list linked with offset_ptr's, written out and mapped back at another address.
+void round_trip ( std::string const & path_ ) {
+    arena a;
+    node * head = nullptr;
+    for ( std::uint32_t i = 0u; i < 100u; ++i ) {
+        node * n = ::new ( a.allocate ( sizeof ( node ), alignof ( node ) ) ) node{ };
+        n->value = i;
+        n->next  = head;
+        head     = n;
+    }
+    CHECK ( throws<std::invalid_argument> ( [ & ] { save_image ( a, a.data ( ) + a.used ( ), path_.c_str ( ) ); } ) );
+    save_image ( a, head, path_.c_str ( ) );
+    {
+        pool_image const i ( path_.c_str ( ) );
+        CHECK ( i.size ( ) == a.used ( ) and i.data ( ) != a.data ( ) );
+        std::uint32_t v = 100u;
+        for ( node const * n = i.root<node> ( ); n; n = n->next.get ( ) )
+            CHECK ( n->value == --v );
+        CHECK ( v == 0u );
+    }
+    {
+        pool_image i ( path_.c_str ( ), pool_image::mode::copy_on_write );
+        i.root<node> ( )->value = 1'000u; // Private to this mapping.
+        CHECK ( i.root<node> ( )->next->value == 98u );
+    }
+    pool_image const i ( path_.c_str ( ) );
+    CHECK ( i.root<node> ( )->value == 99u );
+}
+
+// A missing or unmappable file fails with its system error, a file that is not an image as invalid.
+void open_errors ( std::string const & path_ ) {
+    std::filesystem::remove ( path_ );
+    CHECK ( open_error ( path_ ) == ENOENT );
+    CHECK ( open_error ( std::filesystem::temp_directory_path ( ).string ( ) ) == ENODEV ); // A directory opens, but does not map.
+    std::FILE * f = std::fopen ( path_.c_str ( ), "wb" );
+    CHECK ( f );
+    std::fclose ( f );
+    CHECK ( open_error ( path_ ) == 0 );
+    f = std::fopen ( path_.c_str ( ), "wb" );
+    CHECK ( f and std::fputs ( "not an image, not an image, not an image", f ) >= 0 );
+    std::fclose ( f );
+    CHECK ( open_error ( path_ ) == 0 );
+    std::filesystem::remove ( path_ );
+}
+
+int main ( ) {
+    std::string const path = temp_path ( "static_deque_test_pool_image.bin" );
+    round_trip ( path );
+    open_errors ( path );
+    return EXIT_SUCCESS;
+}
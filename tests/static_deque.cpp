@@ -0,0 +1,389 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <static_deque.hpp>
+
+#include "check.hpp"
+
+// Every element type counts its instances, copies throw when the count down reaches 0.
+
+inline long live_items     = 0;
+inline long copy_countdown = -1;
+
+inline void maybe_throw ( ) {
+    if ( copy_countdown > 0 and not --copy_countdown )
+        throw std::bad_alloc ( );
+}
+
+// Not trivially relocatable, moves do not throw.
+struct item {
+    std::string s;
+
+    item ( int v_ = 0 ) : s ( std::to_string ( v_ ) + "_does_not_fit_the_small_string_buffer" ) { ++live_items; }
+    item ( item const & i_ ) : s ( ( maybe_throw ( ), i_.s ) ) { ++live_items; }
+    item ( item && i_ ) noexcept : s ( std::move ( i_.s ) ) { ++live_items; }
+    item & operator= ( item const & ) = default;
+    item & operator= ( item && ) = default;
+    ~item ( ) noexcept { --live_items; }
+
+    [[nodiscard]] bool operator== ( item const & i_ ) const noexcept { return s == i_.s; }
+};
+
+// Moves may throw (they do not, but a static_deque can only give the basic guarantee).
+struct fragile {
+    int v;
+
+    fragile ( int v_ = 0 ) noexcept : v ( v_ ) { ++live_items; }
+    fragile ( fragile const & f_ ) : v ( ( maybe_throw ( ), f_.v ) ) { ++live_items; }
+    fragile ( fragile && f_ ) : v ( f_.v ) { ++live_items; }
+    fragile & operator= ( fragile const & ) = default;
+    fragile & operator= ( fragile && ) = default;
+    ~fragile ( ) noexcept { --live_items; }
+
+    [[nodiscard]] bool operator== ( fragile const & f_ ) const noexcept { return v == f_.v; }
+};
+
+template<typename Type>
+struct counting_allocator {
+    using value_type = Type;
+
+    static inline std::size_t allocations = 0;
+
+    counting_allocator ( ) noexcept = default;
+    template<typename U>
+    counting_allocator ( counting_allocator<U> const & ) noexcept {}
+
+    [[nodiscard]] Type * allocate ( std::size_t n_ ) {
+        ++allocations;
+        return std::allocator<Type> ( ).allocate ( n_ );
+    }
+    void deallocate ( Type * p_, std::size_t n_ ) noexcept { std::allocator<Type> ( ).deallocate ( p_, n_ ); }
+
+    template<typename U>
+    [[nodiscard]] bool operator== ( counting_allocator<U> const & ) const noexcept {
+        return true;
+    }
+};
+
+template<typename Deque, typename Reference>
+void check_equal ( Deque const & d_, Reference const & r_ ) {
+    CHECK ( d_.size ( ) == r_.size ( ) );
+    CHECK ( std::equal ( d_.begin ( ), d_.end ( ), r_.begin ( ), r_.end ( ) ) );
+    CHECK ( std::equal ( d_.rbegin ( ), d_.rend ( ), r_.rbegin ( ), r_.rend ( ) ) );
+    for ( std::size_t i = 0; i < r_.size ( ); i += 1 + i / 8 )
+        CHECK ( d_[ static_cast<typename Deque::size_type> ( i ) ] == r_[ i ] );
+}
+
+// Random operations on a Deque and a std::deque, with copies that throw now and then. If Type moves without throwing, a
+// failed operation must leave the deque as it was, otherwise it must still be valid.
+template<typename Deque>
+void compare_with_std_deque ( int rounds_ ) {
+    using value_type = typename Deque::value_type;
+    sax::splitmix64 rng ( 0x5eed );
+    for ( int round = 0; round < rounds_; ++round ) {
+        Deque d;
+        std::deque<value_type> r;
+        for ( int op = 0; op < 500; ++op ) {
+            std::size_t const i = below ( rng, r.size ( ) + 1 ), n = below ( rng, below ( rng, 4 ) ? 9 : 100 );
+            std::vector<value_type> src;
+            for ( std::size_t j = 0; j < n; ++j )
+                src.emplace_back ( static_cast<int> ( below ( rng, 1'000 ) ) );
+            if ( not below ( rng, 7 ) )
+                copy_countdown = static_cast<long> ( 1 + below ( rng, n + 1 ) );
+            auto const at = [ & ] ( std::size_t k_ ) { return d.begin ( ) + static_cast<std::ptrdiff_t> ( k_ ); };
+            auto const rat = [ & ] ( std::size_t k_ ) { return r.begin ( ) + static_cast<std::ptrdiff_t> ( k_ ); };
+            try {
+                // The std::deque is changed after copy_countdown is reset, libstdc++ 12 corrupts a std::deque on an
+                // insert of an empty range in the middle, hence the tests for n.
+                switch ( below ( rng, 12 ) ) {
+                    case 0:
+                        d.insert ( at ( i ), src.begin ( ), src.end ( ) );
+                        copy_countdown = -1;
+                        if ( n )
+                            r.insert ( rat ( i ), src.begin ( ), src.end ( ) );
+                        break;
+                    case 1:
+                        d.append_range ( src );
+                        copy_countdown = -1;
+                        r.insert ( r.end ( ), src.begin ( ), src.end ( ) );
+                        break;
+                    case 2:
+                        d.prepend_range ( src );
+                        copy_countdown = -1;
+                        r.insert ( r.begin ( ), src.begin ( ), src.end ( ) );
+                        break;
+                    case 3: {
+                        std::size_t const m = std::min ( n, r.size ( ) - i );
+                        d.erase ( at ( i ), at ( i + m ) );
+                        if ( m )
+                            r.erase ( rat ( i ), rat ( i + m ) );
+                    } break;
+                    case 4:
+                        if ( i < r.size ( ) ) {
+                            d.erase ( at ( i ) );
+                            r.erase ( rat ( i ) );
+                        }
+                        break;
+                    case 5: {
+                        value_type const v ( static_cast<int> ( n ) );
+                        d.insert ( at ( i ), v );
+                        copy_countdown = -1;
+                        r.insert ( rat ( i ), v );
+                    } break;
+                    case 6: {
+                        std::size_t const m = below ( rng, 300 );
+                        copy_countdown      = -1;
+                        d.resize ( static_cast<typename Deque::size_type> ( m ) );
+                        r.resize ( m );
+                    } break;
+                    case 7: {
+                        value_type const v ( 7 );
+                        d.insert ( at ( i ), static_cast<typename Deque::size_type> ( n ), v );
+                        copy_countdown = -1;
+                        if ( n )
+                            r.insert ( rat ( i ), n, v );
+                    } break;
+                    case 8:
+                        d.emplace_back ( static_cast<int> ( n ) );
+                        d.emplace_front ( static_cast<int> ( i ) );
+                        r.emplace_back ( static_cast<int> ( n ) );
+                        r.emplace_front ( static_cast<int> ( i ) );
+                        break;
+                    case 9:
+                        for ( std::size_t k = std::min ( n, r.size ( ) ); k--; ) {
+                            d.pop_front ( );
+                            r.pop_front ( );
+                        }
+                        if ( not r.empty ( ) ) {
+                            d.pop_back ( );
+                            r.pop_back ( );
+                        }
+                        break;
+                    case 10: {
+                        std::list<value_type> const l ( src.begin ( ), src.end ( ) );
+                        d.insert ( at ( i ), l.begin ( ), l.end ( ) );
+                        copy_countdown = -1;
+                        if ( n )
+                            r.insert ( rat ( i ), l.begin ( ), l.end ( ) );
+                    } break;
+                    case 11: {
+                        copy_countdown = -1;
+                        Deque c ( d );
+                        check_equal ( c, r );
+                        d = std::move ( c );
+                        if ( not below ( rng, 4 ) )
+                            d.shrink_to_fit ( );
+                        Deque e;
+                        e.swap ( d );
+                        d = e;
+                    } break;
+                }
+            }
+            catch ( std::bad_alloc const & ) {
+                copy_countdown = -1;
+                if constexpr ( not std::is_nothrow_move_constructible_v<value_type> )
+                    r.assign ( d.begin ( ), d.end ( ) );
+            }
+            copy_countdown = -1;
+            check_equal ( d, r );
+        }
+    }
+}
+
+void segmented_algorithms ( ) {
+    static_deque<int, std::uint32_t, 8> d;
+    std::deque<int> r;
+    for ( int i = 0; i < 100; ++i ) {
+        d.push_front ( i );
+        r.push_front ( i );
+    }
+    for ( std::size_t f = 0; f < 100; f += 7 ) {
+        for ( std::size_t l = f; l <= 100; l += 5 ) {
+            auto const df = d.begin ( ) + static_cast<std::ptrdiff_t> ( f ), dl = d.begin ( ) + static_cast<std::ptrdiff_t> ( l );
+            auto const rf = r.begin ( ) + static_cast<std::ptrdiff_t> ( f ), rl = r.begin ( ) + static_cast<std::ptrdiff_t> ( l );
+            long sum = 0;
+            for_each ( df, dl, [ &sum ] ( int v_ ) { sum += v_; } );
+            CHECK ( sum == std::accumulate ( rf, rl, 0l ) );
+            std::vector<int> out;
+            copy ( df, dl, std::back_inserter ( out ) );
+            CHECK ( std::equal ( out.begin ( ), out.end ( ), rf, rl ) );
+            CHECK ( find ( df, dl, 42 ) - d.begin ( ) == std::find ( rf, rl, 42 ) - r.begin ( ) );
+            CHECK ( dl - df == static_cast<std::ptrdiff_t> ( l - f ) and df <= dl );
+        }
+    }
+    fill ( d.begin ( ) + 3, d.end ( ) - 3, -1 );
+    std::fill ( r.begin ( ) + 3, r.end ( ) - 3, -1 );
+    check_equal ( d, r );
+    static_assert ( std::random_access_iterator<static_deque<int, std::uint32_t, 8>::iterator> );
+}
+
+void constructors ( ) {
+    std::istringstream in ( "1 2 3 4 5" );
+    static_deque<int, std::uint32_t, 2> d{ std::istream_iterator<int> ( in ), std::istream_iterator<int> ( ) };
+    d.insert ( d.begin ( ) + 2, { 9, 9 } );
+    check_equal ( d, std::deque<int>{ 1, 2, 9, 9, 3, 4, 5 } );
+    check_equal ( static_deque<int, std::uint32_t, 2> ( 3u, 4 ), std::deque<int> ( 3u, 4 ) );
+    check_equal ( static_deque<int, std::uint32_t, 2> ( 3u ), std::deque<int> ( 3u ) );
+    CHECK ( throws<std::out_of_range> ( [ & ] { (void) d.at ( 7u ); } ) );
+    static_deque<int, std::uint8_t, 16> s;
+    CHECK ( throws<std::length_error> ( [ & ] {
+        for ( int i = 0; i < 256; ++i )
+            s.push_back ( i );
+    } ) );
+}
+
+// A queue in a steady state allocates nothing after its first chunks, an inline deque nothing at all while it fits.
+void allocations ( ) {
+    using allocator = counting_allocator<int>;
+    {
+        static_deque<int, std::uint32_t, 16, allocator> q;
+        for ( int i = 0; i < 64; ++i )
+            q.push_back ( i );
+        std::size_t const a = allocator::allocations;
+        for ( int i = 0; i < 100'000; ++i ) {
+            q.push_back ( i );
+            q.pop_front ( );
+        }
+        CHECK ( allocator::allocations == a );
+    }
+    allocator::allocations = 0;
+    {
+        small_static_deque<int, std::uint32_t, 32, allocator> a, b;
+        for ( int i = 0; i < 32; ++i )
+            a.push_back ( i );
+        b = std::move ( a );
+        a.swap ( b );
+        CHECK ( a.size ( ) == 32u and b.empty ( ) and allocator::allocations == 0u );
+        a.push_back ( 32 );
+        CHECK ( allocator::allocations > 0u );
+    }
+}
+
+// A deque on a stack_allocator takes its chunks and its map from the buffer. A copy to, or a move assignment into, a deque on
+// another buffer copies or moves the elements over.
+void stack_allocated ( ) {
+    using allocator = stack_allocator<int, 16'384u, 64u, overflow_policy::fail>;
+    using deque     = static_deque<int, std::uint32_t, 16, allocator>;
+    allocator::storage_type s, t;
+    auto in = [] ( allocator::storage_type const & s_, deque const & d_ ) {
+        return std::all_of ( d_.begin ( ), d_.end ( ),
+                             [ & ] ( int const & e_ ) { return s_.pointer_in_buffer ( reinterpret_cast<char const *> ( &e_ ) ); } );
+    };
+    std::deque<int> r;
+    deque a{ allocator ( s ) };
+    for ( int i = 0; i < 200; ++i ) {
+        a.push_back ( i );
+        r.push_back ( i );
+    }
+    CHECK ( in ( s, a ) and s.used ( ) >= 200u * sizeof ( int ) and t.used ( ) == 0u );
+    deque b ( a, allocator ( t ) ), c ( a );
+    check_equal ( b, r );
+    check_equal ( c, r );
+    CHECK ( in ( t, b ) and in ( s, c ) );
+    CHECK ( c.get_allocator ( ) == a.get_allocator ( ) and b.get_allocator ( ) != a.get_allocator ( ) );
+    a.push_front ( -1 );
+    b = std::move ( a ); // The allocators differ and do not propagate, so the elements move.
+    r.push_front ( -1 );
+    check_equal ( b, r );
+    CHECK ( in ( t, b ) );
+    CHECK ( throws<std::bad_alloc> ( [ & ] {
+        for ( ;; )
+            c.push_back ( 0 );
+    } ) );
+}
+
+// Freeing the top allocation rolls the arena back, other frees only count at reset ( ). What does not fit is handled by the
+// overflow policy, or by the upstream resource of a monotonic_stack_resource.
+void monotonic_arena ( ) {
+    aligned_stack_storage_<256u, 16u, overflow_policy::fail> f;
+    char * a = f.allocate ( 10u );
+    char * b = f.allocate ( 1u, 1u );
+    char * c = f.allocate ( 8u, 8u );
+    CHECK ( a == f.data ( ) and b == a + 10 and c == a + 16 and f.used ( ) == 24u );
+    f.deallocate ( b, 1u, 1u ); // Not the top.
+    CHECK ( f.used ( ) == 24u );
+    f.deallocate ( c, 8u, 8u );
+    CHECK ( f.used ( ) == 16u and f.allocate ( 200u ) == a + 16 and f.high_water ( ) == 216u );
+    CHECK ( not f.try_allocate ( 64u ) and throws<std::bad_alloc> ( [ & ] { (void) f.allocate ( 64u ); } ) );
+    f.reset ( );
+    CHECK ( f.used ( ) == 0u and f.high_water ( ) == 216u and f.allocate ( 256u ) == a );
+
+    aligned_stack_storage_<64u, 16u, overflow_policy::upstream> u;
+    char * d = u.allocate ( 48u );
+    char * e = u.allocate ( 32u, 32u ); // From the heap, 32 byte aligned.
+    CHECK ( u.pointer_in_buffer ( d ) and not u.pointer_in_buffer ( e ) and reinterpret_cast<std::uintptr_t> ( e ) % 32u == 0u );
+    u.deallocate ( e, 32u, 32u );
+    CHECK ( u.used ( ) == 48u );
+
+    monotonic_stack_resource<256u> r ( std::pmr::null_memory_resource ( ) );
+    {
+        std::pmr::vector<int> v ( &r );
+        v.reserve ( 32u );
+        CHECK ( r.storage ( ).pointer_in_buffer ( reinterpret_cast<char const *> ( v.data ( ) ) ) );
+        CHECK ( throws<std::bad_alloc> ( [ & ] { v.reserve ( 64u ); } ) );
+    }
+    r.release ( );
+    CHECK ( r.storage ( ).used ( ) == 0u );
+    monotonic_stack_resource<256u> h;
+    std::pmr::vector<int> w ( &h );
+    for ( int i = 0; i < 1'000; ++i )
+        w.push_back ( i );
+    CHECK ( not h.storage ( ).pointer_in_buffer ( reinterpret_cast<char const *> ( w.data ( ) ) ) and w[ 999 ] == 999 );
+}
+
+// Chunks fill whole pages, or waste little of the last one.
+static_assert ( chunk_layout<24u>::size == 512u and chunk_layout<24u>::granules == 3u and chunk_layout<24u>::waste == 0u );
+static_assert ( chunk_layout<8u>::bytes == page_size and chunk_layout<100u>::waste == 0u );
+static_assert ( chunk_layout<1'000u>::bytes <= 64u * page_size and chunk_layout<1'000u>::waste < page_size );
+
+int main ( ) {
+    compare_with_std_deque<static_deque<int, std::uint32_t, 8>> ( 100 );
+    compare_with_std_deque<static_deque<int, std::uint16_t, 16>> ( 50 );
+    compare_with_std_deque<static_deque<item, std::uint32_t, 8>> ( 100 );
+    compare_with_std_deque<small_static_deque<item, std::uint32_t, 16>> ( 50 );
+    compare_with_std_deque<static_deque<fragile, std::uint32_t, 4>> ( 50 );
+    CHECK ( live_items == 0 );
+    segmented_algorithms ( );
+    constructors ( );
+    allocations ( );
+    stack_allocated ( );
+    monotonic_arena ( );
+    return EXIT_SUCCESS;
+}
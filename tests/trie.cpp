@@ -0,0 +1,135 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <trie.hpp>
+
+#include "check.hpp"
+
+// Keys over a small alphabet share long prefixes, keys over all bytes make wide nodes.
+[[nodiscard]] std::string random_key ( sax::splitmix64 & rng_, bool wide_ ) {
+    std::size_t const n = below ( rng_, below ( rng_, 8 ) ? 12 : 60 );
+    std::string k;
+    for ( std::size_t i = 0; i < n; ++i )
+        k.push_back ( static_cast<char> ( wide_ ? below ( rng_, 256 ) : 'a' + below ( rng_, 3 ) ) );
+    return k;
+}
+
+template<typename Trie>
+void check_equal ( Trie & t_, std::map<std::string, int> const & m_ ) {
+    CHECK ( t_.size ( ) == m_.size ( ) );
+    auto i = m_.begin ( );
+    t_.for_each ( [ & ] ( std::string_view k_, int v_ ) {
+        CHECK ( i != m_.end ( ) and k_ == i->first and v_ == i->second );
+        ++i;
+    } );
+    CHECK ( i == m_.end ( ) );
+}
+
+// Random insertions, lookups and removals against a std::map.
+void compare_with_std_map ( bool wide_ ) {
+    sax::splitmix64 rng ( wide_ ? 0xa11 : 0xb22 );
+    radix_trie<int> t;
+    std::map<std::string, int> m;
+    for ( int op = 0; op < 40'000; ++op ) {
+        std::string const k = random_key ( rng, wide_ );
+        switch ( below ( rng, 4 ) ) {
+            case 0:
+            case 1: {
+                auto [ p, inserted ] = t.try_emplace ( k, op );
+                auto [ i, expected ] = m.try_emplace ( k, op );
+                CHECK ( inserted == expected and *p == i->second );
+            } break;
+            case 2: CHECK ( t.erase ( k ) == ( m.erase ( k ) == 1u ) ); break;
+            case 3: {
+                int const * p = t.find ( k );
+                auto const i  = m.find ( k );
+                CHECK ( i == m.end ( ) ? not p : p and *p == i->second );
+            } break;
+        }
+        if ( not ( op % 5'000 ) )
+            check_equal ( t, m );
+    }
+    check_equal ( t, m );
+
+    // Batched lookups agree with single ones.
+    std::vector<std::string> keys;
+    for ( int i = 0; i < 1'000; ++i ) {
+        auto const k = static_cast<std::ptrdiff_t> ( below ( rng, m.size ( ) ) );
+        keys.push_back ( below ( rng, 2 ) ? random_key ( rng, wide_ ) : std::next ( m.begin ( ), k )->first );
+    }
+    std::vector<std::string_view> views ( keys.begin ( ), keys.end ( ) );
+    std::vector<int const *> found ( keys.size ( ) );
+    std::as_const ( t ).find_many ( views.data ( ), views.size ( ), found.data ( ) );
+    for ( std::size_t i = 0; i < keys.size ( ); ++i )
+        CHECK ( found[ i ] == t.find ( keys[ i ] ) );
+
+    // Cursors, seek ( ) is a lower bound, seek_prefix ( ) visits the keys that start with the prefix.
+    radix_trie<int>::cursor c ( t );
+    for ( std::string const & k : keys ) {
+        auto i = m.lower_bound ( k );
+        for ( bool v = c.seek ( k ); v; v = c.next ( ), ++i )
+            CHECK ( i != m.end ( ) and c.key ( ) == i->first and c.value ( ) == i->second );
+        CHECK ( i == m.end ( ) );
+        std::string const p = k.substr ( 0, k.size ( ) / 2 );
+        i                   = m.lower_bound ( p );
+        for ( bool v = c.seek_prefix ( p ); v; v = c.next ( ), ++i )
+            CHECK ( i != m.end ( ) and c.key ( ) == i->first );
+        CHECK ( i == m.end ( ) or i->first.compare ( 0, p.size ( ), p ) );
+    }
+
+    // Build the same trie from the sorted keys.
+    std::vector<std::string_view> sorted;
+    std::vector<int> values;
+    for ( auto const & [ k, v ] : m ) {
+        sorted.push_back ( k );
+        values.push_back ( v );
+    }
+    radix_trie<int> b;
+    b.build_sorted ( sorted.data ( ), sorted.size ( ), [ & ] ( std::size_t i_ ) { return values[ i_ ]; } );
+    check_equal ( b, m );
+    for ( std::string const & k : keys )
+        CHECK ( ( b.find ( k ) == nullptr ) == ( t.find ( k ) == nullptr ) );
+    if ( sorted.size ( ) > 1u ) {
+        std::swap ( sorted.front ( ), sorted.back ( ) );
+        CHECK ( throws<std::invalid_argument> (
+            [ & ] { b.build_sorted ( sorted.data ( ), sorted.size ( ), [ ] ( std::size_t i_ ) { return int ( i_ ); } ); } ) );
+    }
+}
+
+int main ( ) {
+    compare_with_std_map ( false );
+    compare_with_std_map ( true );
+    return EXIT_SUCCESS;
+}
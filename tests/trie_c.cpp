@@ -0,0 +1,163 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <string>
+#include <vector>
+
+#include "trie.h"
+
+#include "check.hpp"
+
+// Every allocation of the C API goes through these, after fail_after more of them malloc ( ) fails.
+std::size_t live = 0u, fail_after = SIZE_MAX;
+
+void * counting_malloc ( std::size_t size_ ) {
+    if ( not fail_after )
+        return nullptr;
+    --fail_after;
+    void * p = std::malloc ( size_ );
+    live += p != nullptr;
+    return p;
+}
+
+void counting_free ( void * ptr_ ) {
+    live -= ptr_ != nullptr;
+    std::free ( ptr_ );
+}
+
+struct value {
+    std::int64_t key, filler[ 7 ]; // Larger than a slot, so build_sorted ( ) allocates a block per key.
+};
+
+using trie_value = struct trie(value);
+
+void check_keys ( trie_value & t_, std::vector<std::string> const & k_ ) {
+    CHECK ( t_.size == k_.size ( ) );
+    for ( std::size_t i = 0u; i < k_.size ( ); ++i ) {
+        value const * v = static_cast<value const *> ( trie_getp ( &t_, k_[ i ].c_str ( ) ) );
+        CHECK ( v and v->key == static_cast<std::int64_t> ( i ) );
+    }
+}
+
+// A failed trie_build_sorted ( ) leaves the trie as it was, whether the keys were not sorted or malloc ( ) failed.
+void build_sorted_failure_keeps_keys ( ) {
+    std::vector<std::string> old_keys, new_keys;
+    for ( int i = 0; i < 300; ++i )
+        old_keys.push_back ( "old" + std::to_string ( 1'000 + i ) ), new_keys.push_back ( "new" + std::to_string ( 1'000 + i ) );
+    std::vector<char const *> o, n;
+    std::vector<value> v ( new_keys.size ( ) );
+    for ( std::size_t i = 0u; i < new_keys.size ( ); ++i ) {
+        o.push_back ( old_keys[ i ].c_str ( ) );
+        n.push_back ( new_keys[ i ].c_str ( ) );
+        v[ i ].key = static_cast<std::int64_t> ( i );
+    }
+    trie_value t{ }; // What trie_init ( ) does, which only compiles as C.
+    t.s.sz = sizeof ( value );
+    CHECK ( trie_build_sorted ( &t, o.data ( ), v.data ( ), o.size ( ) ) );
+    check_keys ( t, old_keys );
+    std::swap ( n[ 7 ], n[ 8 ] );
+    CHECK ( not trie_build_sorted ( &t, n.data ( ), v.data ( ), n.size ( ) ) );
+    check_keys ( t, old_keys );
+    std::swap ( n[ 7 ], n[ 8 ] );
+    std::size_t const before = live;
+    for ( std::size_t f = 0u;; ++f ) {
+        fail_after = f;
+        int const built = trie_build_sorted ( &t, n.data ( ), v.data ( ), n.size ( ) );
+        fail_after = SIZE_MAX;
+        if ( built )
+            break;
+        check_keys ( t, old_keys );
+        CHECK ( live == before );
+    }
+    check_keys ( t, new_keys );
+    CHECK ( not trie_has ( &t, "old1000" ) );
+    trie_destroynode ( &t.s, t.s.root );
+    CHECK ( live == 0u );
+}
+
+// trie_iter ( ) visits the keys in order, and takes the memory for them through the hooks.
+void iter_uses_hooks ( ) {
+    trie_value t{ };
+    t.s.sz = sizeof ( value );
+    std::vector<std::string> keys;
+    for ( int i = 0; i < 1'000; ++i ) {
+        keys.push_back ( "key" + std::to_string ( 10'000 + i ) );
+        value * v = static_cast<value *> ( ( trie_setp ) ( &t.s, keys.back ( ).c_str ( ) ) ); // trie_set ( ) only compiles as C.
+        CHECK ( v );
+        *v = value{ i, { } };
+    }
+    struct {
+        std::size_t live, visited = 0u;
+    } iter{ live };
+    fail_after = 0u;
+    CHECK ( not trie_iter ( &t, [] ( char const *, void *, void * ) { CHECK ( false ); }, nullptr ) );
+    fail_after = SIZE_MAX;
+    CHECK ( live == iter.live );
+    CHECK ( trie_iter (
+        &t,
+        [] ( char const * key_, void * buf_, void * userp_ ) {
+            auto & i = *static_cast<decltype ( iter ) *> ( userp_ );
+            CHECK ( static_cast<value *> ( buf_ )->key == static_cast<std::int64_t> ( i.visited ) );
+            CHECK ( std::string ( key_ ) == "key" + std::to_string ( 10'000 + i.visited++ ) );
+            CHECK ( live > i.live ); // The keys, taken before the first call.
+        },
+        &iter ) );
+    CHECK ( iter.visited == keys.size ( ) and live == iter.live );
+    trie_destroynode ( &t.s, t.s.root );
+    CHECK ( live == 0u );
+}
+
+// Clearing a trie only visits the keys for a dtor or a value block, either way all memory goes back through the hooks.
+void clear_large ( ) {
+    static std::size_t destroyed = 0u;
+    for ( int kind = 0; kind < 3; ++kind ) { // No dtor and small values, a dtor, large values.
+        trie_value t{ };
+        t.s.sz = kind == 2 ? sizeof ( value ) : sizeof ( std::int64_t );
+        if ( kind == 1 )
+            t.s.dtor = [] ( void *, void * ) { ++destroyed; };
+        destroyed = 0u;
+        for ( int round = 0; round < 2; ++round ) {
+            for ( int i = 0; i < 200'000; ++i )
+                CHECK ( ( trie_setp ) ( &t.s, ( "key" + std::to_string ( i ) ).c_str ( ) ) );
+            CHECK ( t.s.size == 200'000u and live > 0u );
+            trie_destroynode ( &t.s, t.s.root ); // What trie_clear ( ) does.
+            t.s.root = nullptr;
+            t.s.size = t.s.maxh = 0u;
+            CHECK ( live == 0u and destroyed == ( kind == 1 ? 200'000u * ( round + 1u ) : 0u ) );
+        }
+    }
+}
+
+int main ( ) {
+    trie_use_as_malloc ( counting_malloc );
+    trie_use_as_free ( counting_free );
+    build_sorted_failure_keeps_keys ( );
+    iter_uses_hooks ( );
+    clear_large ( );
+    return EXIT_SUCCESS;
+}
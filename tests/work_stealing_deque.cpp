@@ -0,0 +1,94 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <work_stealing_deque.hpp>
+
+#include "check.hpp"
+
+constexpr std::size_t thieves = 3u, values = 20'000u, rounds = 20u;
+
+// The owner pushes every value once (and pops some of them back), thieves steal from the start, the small chunks make the
+// deque grow over and over while they do, mostly with a top that is not chunk aligned. Every value must be taken exactly once.
+void steal_while_growing ( ) {
+    for ( std::size_t round = 0; round < rounds; ++round ) {
+        work_stealing_deque<std::uint64_t, 4u> d;
+        std::unique_ptr<std::atomic<std::uint8_t>[]> taken ( new std::atomic<std::uint8_t>[ values ] ( ) );
+        std::atomic<bool> done = false;
+        auto const take        = [ &taken ] ( std::uint64_t v_ ) {
+            CHECK ( v_ < values );
+            CHECK ( not taken[ v_ ].fetch_add ( 1u, std::memory_order_relaxed ) );
+        };
+        std::vector<std::thread> t;
+        for ( std::size_t i = 0; i < thieves; ++i )
+            t.emplace_back ( [ &d, &done, &take, i ] {
+                std::vector<std::uint64_t> half;
+                while ( not done.load ( std::memory_order_acquire ) or not d.empty_approx ( ) ) {
+                    if ( i ) {
+                        if ( std::optional<std::uint64_t> v = d.steal ( ) )
+                            take ( *v );
+                        else
+                            std::this_thread::yield ( );
+                    }
+                    else {
+                        half.clear ( );
+                        if ( not d.steal_half ( std::back_inserter ( half ) ) )
+                            std::this_thread::yield ( );
+                        for ( std::uint64_t v : half )
+                            take ( v );
+                    }
+                }
+            } );
+        sax::splitmix64 rng ( round );
+        for ( std::uint64_t v = 0; v < values; ++v ) {
+            d.push ( v );
+            if ( not below ( rng, 4 ) )
+                if ( std::optional<std::uint64_t> p = d.pop ( ) )
+                    take ( *p );
+            if ( not below ( rng, 64 ) ) // Lets the thieves in, also on a single core.
+                std::this_thread::yield ( );
+        }
+        done.store ( true, std::memory_order_release );
+        while ( std::optional<std::uint64_t> p = d.pop ( ) )
+            take ( *p );
+        for ( std::thread & i : t )
+            i.join ( );
+        for ( std::size_t v = 0; v < values; ++v )
+            CHECK ( taken[ v ].load ( std::memory_order_relaxed ) == 1u );
+    }
+}
+
+int main ( ) {
+    steal_while_growing ( );
+    return EXIT_SUCCESS;
+}